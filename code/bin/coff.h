@@ -56,4 +56,87 @@ struct scnhdr {
 };
 
 
+/// The symbol table of a MIPS COFF file (also known as ECOFF) starts with a
+/// symbolic header, at `filehdr.f_symptr`.  Only the parts needed to find
+/// the names and addresses of procedures are described here.
+///
+/// `extern/syms.h` describes the same records, but with `long` fields,
+/// which do not match the file on 64-bit hosts; these are prefixed with
+/// `ECOFF_` so that both headers can be included together.
+
+#define SYMMAGIC  0x7009
+
+typedef struct ecoff_hdrr {
+    short magic;          /// `SYMMAGIC`.
+    short vstamp;         /// Version stamp.
+    DWORD ilineMax;       /// Number of line number entries.
+    DWORD cbLine;
+    DWORD cbLineOffset;
+    DWORD idnMax;         /// Dense numbers.
+    DWORD cbDnOffset;
+    DWORD ipdMax;         /// Procedure descriptors.
+    DWORD cbPdOffset;
+    DWORD isymMax;        /// Number of local symbols.
+    DWORD cbSymOffset;    /// File offset of the local symbols.
+    DWORD ioptMax;        /// Optimization entries.
+    DWORD cbOptOffset;
+    DWORD iauxMax;        /// Auxiliary entries.
+    DWORD cbAuxOffset;
+    DWORD issMax;         /// Size of the local strings.
+    DWORD cbSsOffset;     /// File offset of the local strings.
+    DWORD issExtMax;      /// Size of the external strings.
+    DWORD cbSsExtOffset;  /// File offset of the external strings.
+    DWORD ifdMax;         /// Number of file descriptors.
+    DWORD cbFdOffset;     /// File offset of the file descriptors.
+    DWORD crfd;           /// Relative file descriptors.
+    DWORD cbRfdOffset;
+    DWORD iextMax;        /// Number of external symbols.
+    DWORD cbExtOffset;    /// File offset of the external symbols.
+} ECOFF_HDRR;
+
+/// File descriptor: where the local symbols and strings of one source file
+/// are.
+typedef struct ecoff_fdr {
+    DWORD          adr;       /// Memory address of the beginning of file.
+    DWORD          rss;       /// Source file name.
+    DWORD          issBase;   /// First local string of this file.
+    DWORD          cbSs;      /// Size of the local strings.
+    DWORD          isymBase;  /// First local symbol of this file.
+    DWORD          csym;      /// Number of local symbols.
+    DWORD          ilineBase;
+    DWORD          cline;
+    DWORD          ioptBase;
+    DWORD          copt;
+    unsigned short ipdFirst;
+    short          cpd;
+    DWORD          iauxBase;
+    DWORD          caux;
+    DWORD          rfdBase;
+    DWORD          crfd;
+    unsigned       flags;     /// Language, `glevel`, etc.
+    DWORD          cbLineOffset;
+    DWORD          cbLine;
+} ECOFF_FDR;
+
+typedef struct ecoff_symr {
+    DWORD    iss;         /// Name, as an index into a string table.
+    DWORD    value;       /// Address, for procedures.
+    unsigned st : 6;      /// Symbol type.
+    unsigned sc : 5;      /// Storage class.
+    unsigned reserved : 1;
+    unsigned index : 20;
+} ECOFF_SYMR;
+
+/// External symbol: an `ECOFF_SYMR` whose name is in the external strings.
+typedef struct ecoff_extr {
+    short      flags;
+    short      ifd;       /// File descriptor where it is defined.
+    ECOFF_SYMR asym;
+} ECOFF_EXTR;
+
+#define stProc        6  /// Procedure.
+#define stStaticProc 14  /// Procedure local to its file.
+#define scText        1  /// In the text segment.
+
+
 #endif
@@ -92,6 +92,132 @@ WriteOrDie(int fd, const char *buffer, unsigned numBytes)
     }
 }
 
+/// Read `numBytes` at `offset` into a newly allocated buffer.
+static char *
+ReadAtOrDie(int fd, long offset, unsigned numBytes)
+{
+    char *buffer = malloc(numBytes + 1);
+
+    lseek(fd, offset, 0);
+    ReadOrDie(fd, buffer, numBytes);
+    buffer[numBytes] = '\0';
+    return buffer;
+}
+
+typedef struct {
+    int         value;
+    int         order;  // Position in the COFF symbol table.
+    const char *name;
+} Symbol;
+
+/// Order symbols by address, and then by where they were found.
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    const Symbol *x = a, *y = b;
+
+    if (x->value != y->value)
+        return x->value < y->value ? -1 : 1;
+    return x->order - y->order;
+}
+
+/// Copy the names and addresses of the procedures in the COFF symbol table
+/// into the symbol section of the NOFF file (see `noff.h`), which is written
+/// at the current position of `fdOut`.
+///
+/// Procedures are taken from the local symbols of every file descriptor, so
+/// that static ones are found as well, and from the external symbols.  If
+/// several share an address, only the first one is kept.  Stripped files
+/// get no symbol section.
+///
+/// The symbol table is only understood on little endian hosts, because of
+/// the bit fields in `ECOFF_SYMR`.
+static void
+WriteSymbols(int fdIn, int fdOut, const struct filehdr *fileh)
+{
+#ifndef HOST_IS_BIG_ENDIAN
+    ECOFF_HDRR hdr;
+
+    if (fileh->f_symptr == 0)
+        return;
+    lseek(fdIn, fileh->f_symptr, 0);
+    ReadStructOrDie(fdIn, hdr);
+    if (hdr.magic != SYMMAGIC) {
+        fprintf(stderr, "Unknown symbol table, not copied\n");
+        return;
+    }
+
+    ECOFF_FDR  *files   = (ECOFF_FDR *)
+      ReadAtOrDie(fdIn, hdr.cbFdOffset, hdr.ifdMax * sizeof (ECOFF_FDR));
+    ECOFF_SYMR *locals  = (ECOFF_SYMR *)
+      ReadAtOrDie(fdIn, hdr.cbSymOffset, hdr.isymMax * sizeof (ECOFF_SYMR));
+    char       *strings = ReadAtOrDie(fdIn, hdr.cbSsOffset, hdr.issMax);
+    ECOFF_EXTR *externs = (ECOFF_EXTR *)
+      ReadAtOrDie(fdIn, hdr.cbExtOffset, hdr.iextMax * sizeof (ECOFF_EXTR));
+    char *externStrings = ReadAtOrDie(fdIn, hdr.cbSsExtOffset,
+                                      hdr.issExtMax);
+
+    Symbol *symbols = malloc((hdr.isymMax + hdr.iextMax + 1)
+                             * sizeof (Symbol));
+    int     numSymbols = 0;
+
+    for (int i = 0; i < hdr.ifdMax; i++)
+        for (int j = 0; j < files[i].csym; j++) {
+            const ECOFF_SYMR *sym = &locals[files[i].isymBase + j];
+            if ((sym->st == stProc || sym->st == stStaticProc)
+                  && sym->sc == scText) {
+                symbols[numSymbols].value = sym->value;
+                symbols[numSymbols].order = numSymbols;
+                symbols[numSymbols].name
+                  = &strings[files[i].issBase + sym->iss];
+                numSymbols++;
+            }
+        }
+    for (int i = 0; i < hdr.iextMax; i++) {
+        const ECOFF_SYMR *sym = &externs[i].asym;
+        if (sym->st == stProc && sym->sc == scText) {
+            symbols[numSymbols].value = sym->value;
+            symbols[numSymbols].order = numSymbols;
+            symbols[numSymbols].name  = &externStrings[sym->iss];
+            numSymbols++;
+        }
+    }
+
+    qsort(symbols, numSymbols, sizeof (Symbol), CompareSymbols);
+
+    NoffSymbolHeader header;
+    NoffSymbol      *table = malloc((numSymbols + 1) * sizeof (NoffSymbol));
+    int              kept = 0, namesSize = 0;
+
+    for (int i = 0; i < numSymbols; i++) {
+        if (kept > 0 && table[kept - 1].value == symbols[i].value)
+            continue;
+        table[kept].value = symbols[i].value;
+        table[kept].name  = namesSize;
+        symbols[kept].name = symbols[i].name;
+        namesSize += strlen(symbols[i].name) + 1;
+        kept++;
+    }
+
+    printf("Copying %d symbols\n", kept);
+    header.noffSymMagic = NOFFSYMMAGIC;
+    header.numSymbols   = kept;
+    header.namesSize    = namesSize;
+    WriteOrDie(fdOut, (const char *) &header, sizeof header);
+    WriteOrDie(fdOut, (const char *) table, kept * sizeof (NoffSymbol));
+    for (int i = 0; i < kept; i++)
+        WriteOrDie(fdOut, symbols[i].name, strlen(symbols[i].name) + 1);
+
+    free(table);
+    free(symbols);
+    free(externStrings);
+    free(externs);
+    free(strings);
+    free(locals);
+    free(files);
+#endif
+}
+
 void
 main(int argc, char *argv[])
 {
@@ -224,6 +350,9 @@ main(int argc, char *argv[])
         }
     }
 
+    /// The symbols go right after the last segment.
+    WriteSymbols(fdIn, fdOut, &fileh);
+
     lseek(fdOut, 0, 0);
     WriteOrDie(fdOut, (const char *) &noffH, sizeof (NoffHeader));
     close(fdIn);
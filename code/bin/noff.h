@@ -24,5 +24,26 @@ typedef struct noffHeader {
                          // before use.
 } NoffHeader;
 
+/// Optional symbol section.
+///
+/// If present, it follows the last segment stored in the file, that is, it
+/// starts at the largest `inFileAddr + size` of `code` and `initData`.  It
+/// holds this header, then `numSymbols` symbols sorted by address, then
+/// `namesSize` bytes of null-terminated names.  Files without it can still
+/// be loaded.
+
+#define NOFFSYMMAGIC  0xBADF00D  // Magic number of the symbol section.
+
+typedef struct noffSymbolHeader {
+    int noffSymMagic;  // Should be `NOFFSYMMAGIC`.
+    int numSymbols;    // Number of `NoffSymbol` entries.
+    int namesSize;     // Size of the names that follow them.
+} NoffSymbolHeader;
+
+typedef struct noffSymbol {
+    int value;  // Address of the routine.
+    int name;   // Offset of its name among the names.
+} NoffSymbol;
+
 
 #endif
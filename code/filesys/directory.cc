@@ -25,6 +25,9 @@
 #include "threads/utility.hh"
 
 
+SlabAllocator Directory::slab;
+
+
 /// Initialize a directory; initially, the directory is completely empty.  If
 /// the disk is being formatted, an empty directory is all we need, but
 /// otherwise, we need to call FetchFrom in order to initialize it from disk.
@@ -79,6 +82,9 @@ Directory::FindIndex(const char *name)
 /// the file's header is stored.  Return -1 if the name is not in the
 /// directory.
 ///
+/// Only reads the table, so lookups in copies fetched while holding the
+/// file system's directory lock for reading can go on at the same time.
+///
 /// * `name` is the file name to look up.
 int
 Directory::Find(const char *name)
@@ -16,6 +16,7 @@
 
 
 #include "open_file.hh"
+#include "threads/slab.hh"
 
 
 /// For simplicity, we assume file names are <= 9 characters long.
@@ -77,7 +78,16 @@ public:
     /// and their contents.
     void Print();
 
+    /// Directories are taken from a slab, since one is read for every file
+    /// opened, created or removed.
+    void *operator new(size_t size)
+    { return slab.Allocate("directory", size); }
+    void operator delete(void *directory)
+    { slab.Free(directory); }
+
 private:
+    static SlabAllocator slab;
+
     int tableSize;  ///< Number of directory entries.
     DirectoryEntry *table;  ///< Table of pairs:
                             ///< *<file name, file header location>*.
@@ -27,6 +27,9 @@
 #include "threads/system.hh"
 
 
+SlabAllocator FileHeader::slab;
+
+
 /// Initialize a fresh file header for a newly created file.  Allocate data
 /// blocks for the file out of the map of free disk blocks.  Return false if
 /// there are not enough free blocks to accomodate the new file.
@@ -100,7 +103,7 @@ FileHeader::FileLength()
 void
 FileHeader::Print()
 {
-    char *data = new char[SECTOR_SIZE];
+    char data[SECTOR_SIZE];
 
     printf("FileHeader contents.  File size: %d.  File blocks:\n", numBytes);
     for (unsigned i = 0; i < numSectors; i++)
@@ -116,5 +119,4 @@ FileHeader::Print()
         }
         printf("\n");
     }
-    delete [] data;
 }
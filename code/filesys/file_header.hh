@@ -15,6 +15,7 @@
 
 #include "machine/disk.hh"
 #include "userprog/bitmap.hh"
+#include "threads/slab.hh"
 
 
 #define NUM_DIRECT     ((SECTOR_SIZE - 2 * sizeof (int)) / sizeof (int))
@@ -60,7 +61,16 @@ public:
     /// Print the contents of the file.
     void Print();
 
+    /// Headers are taken from a slab, since one is read for every file
+    /// opened, created or removed.
+    void *operator new(size_t size)
+    { return slab.Allocate("file header", size); }
+    void operator delete(void *header)
+    { slab.Free(header); }
+
   private:
+    static SlabAllocator slab;
+
     unsigned numBytes;  ///< Number of bytes in the file
     unsigned numSectors;  ///< Number of data sectors in the file
     unsigned dataSectors[NUM_DIRECT];  ///< Disk sector numbers for each data
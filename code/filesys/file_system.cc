@@ -27,7 +27,9 @@
 ///
 /// Our implementation at this point has the following restrictions:
 ///
-/// * there is no synchronization for concurrent accesses;
+/// * concurrent accesses are only synchronized as far as the directory and
+///   the bitmap go: lookups hold `directoryLock` for reading, so that they
+///   can go on at the same time, and changes hold it for writing;
 /// * files have a fixed size, set when the file is created;
 /// * files cannot be bigger than about 3KB in size;
 /// * there is no hierarchical directory structure, and only a limited number
@@ -46,6 +48,7 @@
 #include "directory.hh"
 #include "file_header.hh"
 #include "machine/disk.hh"
+#include "threads/synch.hh"
 #include "userprog/bitmap.hh"
 
 
@@ -75,6 +78,7 @@ static const unsigned DIRECTORY_FILE_SIZE = sizeof (DirectoryEntry)
 FileSystem::FileSystem(bool format)
 {
     DEBUG('f', "Initializing the file system.\n");
+    directoryLock = new RWLock("directory");
     if (format) {
         BitMap     *freeMap   = new BitMap(NUM_SECTORS);
         Directory  *directory = new Directory(NUM_DIR_ENTRIES);
@@ -158,8 +162,8 @@ FileSystem::FileSystem(bool format)
 /// * no free entry for file in directory;
 /// * no free space for data blocks for the file.
 ///
-/// Note that this implementation assumes there is no concurrent access to
-/// the file system!
+/// The directory lock is held for writing throughout, since the bitmap
+/// changes along with the directory.
 ///
 /// * `name` is the name of file to be created.
 /// * `initialSize` is the size of file to be created.
@@ -174,6 +178,7 @@ FileSystem::Create(const char *name, int initialSize)
 
     DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
 
+    directoryLock->AcquireWrite();
     directory = new Directory(NUM_DIR_ENTRIES);
     directory->FetchFrom(directoryFile);
 
@@ -203,6 +208,7 @@ FileSystem::Create(const char *name, int initialSize)
         delete freeMap;
     }
     delete directory;
+    directoryLock->ReleaseWrite();
     return success;
 }
 
@@ -212,6 +218,9 @@ FileSystem::Create(const char *name, int initialSize)
 /// 1. Find the location of the file's header, using the directory.
 /// 2. Bring the header into memory.
 ///
+/// Both are done holding the directory lock for reading, so that the file
+/// cannot be removed in between, while other opens go on.
+///
 /// * `name` is the text name of the file to be opened.
 OpenFile *
 FileSystem::Open(const char *name)
@@ -221,10 +230,12 @@ FileSystem::Open(const char *name)
     int        sector;
 
     DEBUG('f', "Opening file %s\n", name);
+    directoryLock->AcquireRead();
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector >= 0)
         openFile = new OpenFile(sector);  // `name` was found in directory.
+    directoryLock->ReleaseRead();
     delete directory;
     return openFile;  // Return `NULL` if not found.
 }
@@ -249,11 +260,13 @@ FileSystem::Remove(const char *name)
     FileHeader *fileHeader;
     int         sector;
 
+    directoryLock->AcquireWrite();
     directory = new Directory(NUM_DIR_ENTRIES);
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector == -1) {
        delete directory;
+       directoryLock->ReleaseWrite();
        return false;  // file not found
     }
     fileHeader = new FileHeader;
@@ -271,6 +284,7 @@ FileSystem::Remove(const char *name)
     delete fileHeader;
     delete directory;
     delete freeMap;
+    directoryLock->ReleaseWrite();
     return true;
 }
 
@@ -280,7 +294,9 @@ FileSystem::List()
 {
     Directory *directory = new Directory(NUM_DIR_ENTRIES);
 
+    directoryLock->AcquireRead();
     directory->FetchFrom(directoryFile);
+    directoryLock->ReleaseRead();
     directory->List();
     delete directory;
 }
@@ -39,6 +39,9 @@
 #include "open_file.hh"
 
 
+class RWLock;
+
+
 #ifdef FILESYS_STUB  // Temporarily implement file system calls as calls to
                      // UNIX, until the real file system implementation is
                      // available.
@@ -97,6 +100,8 @@ private:
                            ///< file.
    OpenFile* directoryFile;  ///< “Root” directory -- list of file names,
                              ///< represented as a file.
+   RWLock *directoryLock;  ///< Held for reading to look up the directory,
+                           ///< and for writing to change it or the bitmap.
 };
 
 #endif
@@ -0,0 +1,144 @@
+/// Routines to manage the cache of basic blocks.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "block_cache.hh"
+#include "encoding.hh"
+
+
+/// Return true if `instr` transfers control after its delay slot.
+bool
+IsBranch(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_BEQ:  case OP_BGEZ:   case OP_BGEZAL: case OP_BGTZ:
+        case OP_BLEZ: case OP_BLTZ:   case OP_BLTZAL: case OP_BNE:
+        case OP_J:    case OP_JAL:    case OP_JALR:   case OP_JR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Return true if `instr` always traps into the kernel.
+static bool
+IsTrap(const Instruction *instr)
+{
+    return instr->opCode == OP_SYSCALL || instr->opCode == OP_RES
+           || instr->opCode == OP_UNIMP;
+}
+
+/// Remember that `next` follows this block when it is left at `pc`.
+///
+/// A link made in an earlier epoch is replaced first; otherwise the second
+/// one goes, so that the first link of a loop is the one that stays.
+void
+Block::Link(int pc, Block *next, unsigned epoch)
+{
+    unsigned i = links[0].epoch != epoch ? 0 : BLOCK_LINKS - 1;
+    links[i].pc    = pc;
+    links[i].epoch = epoch;
+    links[i].block = next;
+}
+
+/// Initialize the cache; no block is formed yet.
+///
+/// * `decodeCache` supplies the decoded instructions.
+/// * `nFrames` is the number of physical pages.
+/// * `size` is the size of a page, in bytes.
+BlockCache::BlockCache(DecodeCache *decodeCache, unsigned nFrames,
+                       unsigned size)
+{
+    decoded   = decodeCache;
+    numFrames = nFrames;
+    frameSize = size;
+    frames    = new Block *[numFrames];
+    for (unsigned i = 0; i < numFrames; i++)
+        frames[i] = NULL;
+    epoch = 1;  // Empty links belong to epoch 0.
+}
+
+/// De-allocate the blocks.
+BlockCache::~BlockCache()
+{
+    for (unsigned i = 0; i < numFrames; i++)
+        delete [] frames[i];
+    delete [] frames;
+}
+
+/// Return the block starting at `physAddr`.
+///
+/// * `memory` is the simulated main memory.
+/// * `physAddr` is the word aligned physical address of the first
+///   instruction.
+Block *
+BlockCache::Find(const char *memory, unsigned physAddr)
+{
+    unsigned frame = physAddr / frameSize;
+
+    ASSERT(frame < numFrames);
+    if (frames[frame] == NULL) {
+        frames[frame] = new Block[frameSize / 4];
+        memset(frames[frame], 0, frameSize / 4 * sizeof (Block));
+    }
+
+    Block *block = &frames[frame][physAddr % frameSize / 4];
+    if (block->code == NULL)
+        Form(block, memory, physAddr);
+    return block;
+}
+
+/// Forget the blocks of a page.
+///
+/// Blocks elsewhere may still link to them, so a new epoch is started as
+/// well.
+///
+/// * `frame` is the physical page number.
+void
+BlockCache::InvalidateFrame(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    if (frames[frame] != NULL)
+        memset(frames[frame], 0, frameSize / 4 * sizeof (Block));
+    Unlink();
+}
+
+/// Forget the host code of every block, because the code buffer is about
+/// to be reused.  Blocks will be translated again once they get hot.
+void
+BlockCache::ForgetNative()
+{
+    for (unsigned i = 0; i < numFrames; i++) {
+        if (frames[i] == NULL)
+            continue;
+        for (unsigned j = 0; j < frameSize / 4; j++) {
+            frames[i][j].native = NULL;
+            frames[i][j].hits   = 0;
+        }
+    }
+}
+
+/// Decode the instructions starting at `physAddr` into `block`.
+///
+/// Blocks never cross a page boundary, since the next physical page need
+/// not hold the next virtual page.
+void
+BlockCache::Form(Block *block, const char *memory, unsigned physAddr)
+{
+    unsigned end = (physAddr / frameSize + 1) * frameSize;
+    bool inDelaySlot = false;
+
+    block->code     = decoded->Fetch(memory, physAddr);
+    block->length   = 0;
+    block->physAddr = physAddr;
+    for (unsigned addr = physAddr; addr < end; addr += 4) {
+        const Instruction *instr = decoded->Fetch(memory, addr);
+        block->length++;
+        if (inDelaySlot || IsTrap(instr))
+            break;
+        inDelaySlot = IsBranch(instr);
+    }
+}
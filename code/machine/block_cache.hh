@@ -0,0 +1,142 @@
+/// Data structures for caching basic blocks of user instructions.
+///
+/// A basic block is a run of consecutive instructions that is only left at
+/// its end: it extends up to and including the delay slot of the first
+/// branch or jump, up to a system call or reserved instruction, or up to
+/// the end of the physical page, whichever comes first.  The simulator
+/// executes a whole block without translating the program counter or
+/// looking up the decode cache for each instruction.
+///
+/// Blocks are chained: every block remembers which blocks followed it last
+/// time, keyed by the virtual address at which execution left it.  A link
+/// is a cached translation, so it is only trusted during the *epoch* in
+/// which it was made.  The epoch changes whenever the translation may have
+/// changed (a context switch, an exception or interrupt taken into the
+/// kernel) and whenever a page holding blocks is written.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_BLOCKCACHE__HH
+#define NACHOS_MACHINE_BLOCKCACHE__HH
+
+
+#include "decode_cache.hh"
+#include "threads/utility.hh"
+
+
+/// Number of successors remembered by every block; one for each way out of
+/// a conditional branch.
+const unsigned BLOCK_LINKS = 2;
+
+/// Host code translated from the beginning of a block (see `jit.hh`).
+///
+/// It takes the simulated registers and returns how many instructions it
+/// executed.
+typedef unsigned (*NativeCode)(int *registers);
+
+class Block {
+public:
+
+    /// Return the block that follows this one when it is left at virtual
+    /// address `pc`, or NULL if it is not known during `epoch`.
+    Block *Successor(int pc, unsigned epoch) const
+    {
+        for (unsigned i = 0; i < BLOCK_LINKS; i++)
+            if (links[i].epoch == epoch && links[i].pc == pc)
+                return links[i].block;
+        return NULL;
+    }
+
+    /// Remember that `next` follows this block when it is left at `pc`.
+    void Link(int pc, Block *next, unsigned epoch);
+
+    /// First decoded instruction; the rest follow it in memory.  NULL if
+    /// the block has not been formed.
+    const Instruction *code;
+
+    /// Number of instructions in the block.
+    unsigned length;
+
+    /// Physical address of the first instruction.
+    unsigned physAddr;
+
+    /// Host code for the first `nativeLength` instructions, or NULL if the
+    /// block has not been translated.
+    NativeCode native;
+    unsigned nativeLength;
+
+    /// How many times the block was entered while not translated.
+    unsigned hits;
+
+private:
+
+    struct {
+        int pc;
+        unsigned epoch;
+        Block *block;
+    } links[BLOCK_LINKS];
+
+};
+
+/// Return true if `instr` is a branch or jump, that is, if it has a delay
+/// slot.
+bool IsBranch(const Instruction *instr);
+
+class BlockCache {
+public:
+
+    /// Initialize an empty cache for `numFrames` physical pages of
+    /// `frameSize` bytes each, whose instructions are decoded by `decoded`.
+    BlockCache(DecodeCache *decoded, unsigned numFrames, unsigned frameSize);
+
+    /// De-allocate the cache.
+    ~BlockCache();
+
+    /// Return the block starting at `physAddr`, forming it from `memory` if
+    /// it was not formed yet.
+    Block *Find(const char *memory, unsigned physAddr);
+
+    /// Current epoch.  Links made in an earlier epoch are not followed.
+    unsigned Epoch() const
+    {
+        return epoch;
+    }
+
+    /// Break every link between blocks, by starting a new epoch.
+    void Unlink()
+    {
+        epoch++;
+    }
+
+    /// Forget every block formed from physical page `frame`.
+    void InvalidateFrame(unsigned frame);
+
+    /// Forget the host code of every block, keeping the blocks.
+    void ForgetNative();
+
+private:
+
+    /// Build `block` with the instructions starting at `physAddr`.
+    void Form(Block *block, const char *memory, unsigned physAddr);
+
+    /// Where the instructions come from.
+    DecodeCache *decoded;
+
+    /// Number of physical pages covered.
+    unsigned numFrames;
+
+    /// Size of a page, in bytes.
+    unsigned frameSize;
+
+    /// Blocks of every page, indexed by the word at which they start, and
+    /// allocated on first use.
+    Block **frames;
+
+    unsigned epoch;
+
+};
+
+
+#endif
@@ -23,8 +23,8 @@ private:
 
     char buffer[BUFFER_SIZE];
     int previousRegisters[NUM_TOTAL_REGS];
-    unsigned runUntilTime;  ///< Drop back into the debugger when simulated
-                            ///< time reaches this value.
+    unsigned long long runUntilTime;  ///< Drop back into the debugger when
+                                      ///< simulated time reaches this value.
 };
 
 
@@ -0,0 +1,86 @@
+/// Routines to manage the cache of decoded user instructions.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "decode_cache.hh"
+#include "machine.hh"
+
+
+/// Initialize the cache; nothing is decoded yet.
+///
+/// * `nFrames` is the number of physical pages.
+/// * `size` is the size of a page, in bytes.
+DecodeCache::DecodeCache(unsigned nFrames, unsigned size)
+{
+    numFrames = nFrames;
+    frameSize = size;
+    frames    = new Instruction *[numFrames];
+    live      = new bool[numFrames];
+    for (unsigned i = 0; i < numFrames; i++) {
+        frames[i] = NULL;
+        live[i]   = false;
+    }
+}
+
+/// De-allocate the decoded pages.
+DecodeCache::~DecodeCache()
+{
+    for (unsigned i = 0; i < numFrames; i++)
+        delete [] frames[i];
+    delete [] frames;
+    delete [] live;
+}
+
+/// Return the decoded instruction at `physAddr`.
+///
+/// On a miss, read the raw word from `memory`, decode it and keep the
+/// result, so that the next fetch of the same word is just a lookup.
+///
+/// * `memory` is the simulated main memory.
+/// * `physAddr` is the word aligned physical address of the instruction.
+const Instruction *
+DecodeCache::Fetch(const char *memory, unsigned physAddr)
+{
+    unsigned frame = physAddr / frameSize;
+
+    ASSERT(frame < numFrames);
+    if (frames[frame] == NULL) {
+        frames[frame] = new Instruction[frameSize / 4];
+        memset(frames[frame], 0, frameSize / 4 * sizeof (Instruction));
+    }
+
+    Instruction *instr = &frames[frame][physAddr % frameSize / 4];
+    if (instr->opCode == 0) {  // Not decoded yet.
+        instr->value = WordToHost(*(const unsigned *) &memory[physAddr]);
+        instr->Decode();
+        live[frame] = true;
+    }
+    return instr;
+}
+
+/// Forget the decoded instructions of a page.
+///
+/// The storage is kept, since a page that held code is likely to hold code
+/// again.
+///
+/// * `frame` is the physical page number.
+void
+DecodeCache::InvalidateFrame(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    if (!live[frame])
+        return;
+    memset(frames[frame], 0, frameSize / 4 * sizeof (Instruction));
+    live[frame] = false;
+}
+
+/// Forget the decoded instructions of every page.
+void
+DecodeCache::InvalidateAll()
+{
+    for (unsigned i = 0; i < numFrames; i++)
+        InvalidateFrame(i);
+}
@@ -0,0 +1,81 @@
+/// Data structures for caching decoded user instructions.
+///
+/// Fetching and decoding an instruction is the most repeated piece of work
+/// of the simulator: tight loops in user programs decode the same handful of
+/// words over and over.  The decode cache keeps, for every physical page
+/// that has been executed, the already decoded `Instruction` records, so
+/// that the simulator only needs to decode a word the first time it is
+/// fetched.
+///
+/// The cache is indexed by physical address, so it stays valid across
+/// context switches.  It must be told whenever the contents of a page may
+/// have changed: user stores are reported by `Machine::WriteMem`, and the
+/// kernel must call `Machine::InvalidateFrame` whenever it writes a frame
+/// directly or reassigns it to another virtual page.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_DECODECACHE__HH
+#define NACHOS_MACHINE_DECODECACHE__HH
+
+
+#include "instruction.hh"
+
+
+class DecodeCache {
+public:
+
+    /// Initialize an empty cache for `numFrames` physical pages of
+    /// `frameSize` bytes each.
+    DecodeCache(unsigned numFrames, unsigned frameSize);
+
+    /// De-allocate the cache.
+    ~DecodeCache();
+
+    /// Return the decoded instruction stored at `physAddr`, decoding it
+    /// from `memory` if this is the first time it is fetched.
+    ///
+    /// `physAddr` must be word aligned.
+    const Instruction *Fetch(const char *memory, unsigned physAddr);
+
+    /// Notify that the word at `physAddr` has been written.
+    ///
+    /// Return true if the page held decoded instructions, which had to be
+    /// forgotten.  Cheap if nothing was ever decoded from that page, which
+    /// is the common case for data pages.
+    bool Written(unsigned physAddr)
+    {
+        unsigned frame = physAddr / frameSize;
+        if (!live[frame])
+            return false;
+        InvalidateFrame(frame);
+        return true;
+    }
+
+    /// Forget every instruction decoded from physical page `frame`.
+    void InvalidateFrame(unsigned frame);
+
+    /// Forget everything.
+    void InvalidateAll();
+
+private:
+
+    /// Number of physical pages covered.
+    unsigned numFrames;
+
+    /// Size of a page, in bytes.
+    unsigned frameSize;
+
+    /// Decoded instructions of every page, allocated on first use.  An
+    /// entry whose `opCode` is zero has not been decoded yet.
+    Instruction **frames;
+
+    /// Whether a page has any decoded entry.
+    bool *live;
+
+};
+
+
+#endif
@@ -214,7 +214,7 @@ Disk::ComputeLatency(unsigned newSector, bool writing)
 {
     unsigned rotation;
     unsigned seek      = TimeToSeek(newSector, &rotation);
-    unsigned timeAfter = stats->totalTicks + seek + rotation;
+    unsigned long long timeAfter = stats->totalTicks + seek + rotation;
 
 #ifndef NOTRACKBUF  // Turn this on if you do not want the track buffer
                     // stuff.
@@ -246,5 +246,5 @@ Disk::UpdateLast(unsigned newSector)
     if (seek != 0)
         bufferInit = stats->totalTicks + seek + rotate;
     lastSector = newSector;
-    DEBUG('d', "Updating last sector = %u, %u\n", lastSector, bufferInit);
+    DEBUG('d', "Updating last sector = %u, %llu\n", lastSector, bufferInit);
 }
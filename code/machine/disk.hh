@@ -89,7 +89,8 @@ private:
     void* handlerArg;  ///< Argument to interrupt handler.
     bool active;  ///< Is a disk operation in progress?
     unsigned lastSector;  ///< The previous disk request.
-    int bufferInit;  ///< When the track buffer started being loaded.
+    unsigned long long bufferInit;  ///< When the track buffer started being
+                                    ///< loaded.
                      // being loaded
 
     /// Time to get to the new track.
@@ -24,6 +24,7 @@
 #include "threads/system.hh"
 
 #include <limits.h>
+#include <string.h>
 
 
 // String definitions for debugging messages
@@ -31,7 +32,7 @@
 static const char *INT_LEVEL_NAMES[] = { "off", "on" };
 static const char *INT_TYPE_NAMES[]  = {
     "timer", "disk", "console write", "console read",
-    "network send", "network recv"
+    "network send", "network recv", "timeout", "alarm"
 };
 
 /// Initialize a hardware device interrupt that is to be scheduled to occur
@@ -42,7 +43,7 @@ static const char *INT_TYPE_NAMES[]  = {
 /// * `time` is when (in simulated time) the interrupt is to occur.
 /// * `kind` is the hardware device that generated the interrupt.
 PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
-                                   unsigned time, IntType kind)
+                                   unsigned long long time, IntType kind)
 {
     handler = func;
     arg     = param;
@@ -50,13 +51,121 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
     type    = kind;
 }
 
+PendingQueue::PendingQueue()
+{
+    numPending = 0;
+    maxPending = 16;
+    heap       = new PendingInterrupt[maxPending];
+    arrivals   = 0;
+}
+
+PendingQueue::~PendingQueue()
+{
+    delete [] heap;
+}
+
+/// Add an interrupt to the queue, growing the array if it is full.
+///
+/// * `pend` is the interrupt; its `order` is assigned here.
+void
+PendingQueue::Insert(const PendingInterrupt &pend)
+{
+    if (numPending == maxPending) {
+        PendingInterrupt *bigger = new PendingInterrupt[2 * maxPending];
+        memcpy(bigger, heap, numPending * sizeof *heap);
+        delete [] heap;
+        heap = bigger;
+        maxPending *= 2;
+    }
+    heap[numPending] = pend;
+    heap[numPending].order = arrivals++;
+    SiftUp(numPending++);
+}
+
+void
+PendingQueue::RemoveFirst()
+{
+    ASSERT(numPending > 0);
+    heap[0] = heap[--numPending];
+    SiftDown(0);
+}
+
+/// Nothing has to move unless another interrupt is due at the same time,
+/// and then it is one of the children of the first.
+void
+PendingQueue::Requeue()
+{
+    ASSERT(numPending > 0);
+    if ((numPending < 2 || heap[1].when != heap[0].when)
+          && (numPending < 3 || heap[2].when != heap[0].when))
+        return;
+    heap[0].order = arrivals++;
+    SiftDown(0);
+}
+
+/// Every interrupt due at the same time as the first one has only such
+/// interrupts above it in the heap, so only those have to be visited.
+unsigned
+PendingQueue::CountTies() const
+{
+    return numPending == 0 ? 0 : CountTies(0);
+}
+
+unsigned
+PendingQueue::CountTies(unsigned i) const
+{
+    if (i >= numPending || heap[i].when != heap[0].when)
+        return 0;
+    return 1 + CountTies(2 * i + 1) + CountTies(2 * i + 2);
+}
+
+void
+PendingQueue::Sorted(PendingInterrupt *pends) const
+{
+    for (unsigned i = 0; i < numPending; i++) {  // Insertion sort.
+        unsigned j = i;
+        for (; j > 0 && Before(heap[i], pends[j - 1]); j--)
+            pends[j] = pends[j - 1];
+        pends[j] = heap[i];
+    }
+}
+
+void
+PendingQueue::SiftUp(unsigned i)
+{
+    PendingInterrupt pend = heap[i];
+
+    for (; i > 0 && Before(pend, heap[(i - 1) / 2]); i = (i - 1) / 2)
+        heap[i] = heap[(i - 1) / 2];
+    heap[i] = pend;
+}
+
+void
+PendingQueue::SiftDown(unsigned i)
+{
+    PendingInterrupt pend = heap[i];
+
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= numPending)
+            break;
+        if (child + 1 < numPending && Before(heap[child + 1], heap[child]))
+            child++;
+        if (!Before(heap[child], pend))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = pend;
+}
+
 /// Initialize the simulation of hardware device interrupts.
 ///
 /// Interrupts start disabled, with no interrupts pending, etc.
 Interrupt::Interrupt()
 {
     level         = INT_OFF;
-    pending       = new List<PendingInterrupt *>;
+    pending       = new PendingQueue;
     inHandler     = false;
     yieldOnReturn = false;
     status        = SYSTEM_MODE;
@@ -65,8 +174,6 @@ Interrupt::Interrupt()
 /// De-allocate the data structures needed by the interrupt simulation.
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-        delete pending->Remove();
     delete pending;
 }
 
@@ -134,7 +241,7 @@ Interrupt::OneTick()
     stats->totalTicks += USER_TICK;
     stats->userTicks += USER_TICK;
     }
-    DEBUG('i', "\n== Tick %u ==\n", stats->totalTicks);
+    DEBUG('i', "\n== Tick %llu ==\n", stats->totalTicks);
 
     // Check any pending interrupts are now ready to fire.
     ChangeLevel(INT_ON, INT_OFF);  // First, turn off interrupts (interrupt
@@ -151,6 +258,54 @@ Interrupt::OneTick()
     }
 }
 
+/// Return how many user instructions can run before an interrupt fires.
+///
+/// That is, the `OneTick` that follows the returned number of user
+/// instructions is the first one that finds an interrupt due; the ones
+/// before it only advance the clock.  Returns `UINT_MAX` if nothing is
+/// pending.
+unsigned
+Interrupt::TicksUntilDue()
+{
+    if (pending->IsEmpty())
+        return UINT_MAX;
+
+    unsigned long long when = pending->First()->when;
+    if (when <= stats->totalTicks)
+        return 1;
+
+    unsigned long long ticks = (when - stats->totalTicks + USER_TICK - 1)
+                               / USER_TICK;
+    return ticks < UINT_MAX ? ticks : UINT_MAX;
+}
+
+/// Advance simulated time as `ticks` calls to `OneTick` in user mode would,
+/// when none of them finds an interrupt due.
+///
+/// Each of those calls would have taken the first pending interrupt out and
+/// sorted it back in, behind any other interrupt due at the same time, so
+/// those are rotated the same way, to keep the order in which they will
+/// fire.
+///
+/// * `ticks` is the number of user ticks; it must be less than
+///   `TicksUntilDue()`.
+void
+Interrupt::AdvanceUserTicks(unsigned ticks)
+{
+    ASSERT(status == USER_MODE);
+    ASSERT(ticks < TicksUntilDue());
+
+    if (ticks == 0)
+        return;
+    stats->totalTicks += ticks * USER_TICK;
+    stats->userTicks  += ticks * USER_TICK;
+
+    unsigned numTies = pending->CountTies();
+    if (numTies > 1)
+        for (unsigned i = ticks % numTies; i > 0; i--)
+            pending->Requeue();
+}
+
 /// Called from within an interrupt handler, to cause a context switch (for
 /// example, on a time slice) in the interrupted thread, when the handler
 /// returns.
@@ -203,42 +358,16 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    machine->PrintProfile();
+#endif
     Cleanup();  // Never returns.
 }
 
-#ifdef DFS_TICKS_FIX
-/// Restart the total ticks statistic and the pending interrupts list.
-///
-/// This function makes sure Nachos keeps working even after overflowing the
-/// tick counter.  After some time (when `totalTicks` reach the maximum
-/// positive number) Nachos would schedule a pending interrupt at a negative
-/// time, and after that, it would hang.
-void Interrupt::RestartTicks()
-{
-    PendingInterrupt *i = NULL;
-    unsigned          newWhen, oldWhen = 0;
-
-    List<PendingInterrupt *> *oldPending = pending;
-    pending = new List<PendingInterrupt *>;
-
-    while ((i = oldPending->SortedRemove((int *) &oldWhen)) != NULL)
-    {
-        newWhen = oldWhen - stats->totalTicks;
-        pending->SortedInsert(i, newWhen);
-        DEBUG('x', "Interrupt at time %u re-scheduled at new time %u.\n",
-              oldWhen, newWhen);
-    }
-
-    delete oldPending;
-    stats->totalTicks = 0;
-    stats->tickResets += 1;
-}
-#endif
-
 /// Arrange for the CPU to be interrupted when simulated time reaches `now +
 /// when`.
 ///
-/// Implementation: just put it on a sorted list.
+/// Implementation: just put it in a priority queue.
 ///
 /// NOTE: the Nachos kernel should not call this routine directly.  Instead,
 /// it is only called by the hardware device simulators.
@@ -252,27 +381,13 @@ void
 Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
                     unsigned fromNow, IntType type)
 {
-#ifdef DFS_TICKS_FIX
-    if (UINT_MAX - stats->totalTicks < fromNow)
-    {
-        DEBUG('x', "WARNING: total tick count is too large"
-                   " and will be reset.\n");
-        RestartTicks();
-    }
-#else
-    // Terminate Nachos if the ticks overflowed.
-    ASSERT(UINT_MAX - stats->totalTicks < fromNow);
-#endif
-
-    unsigned when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg,
-                                                     when, type);
+    unsigned long long when = stats->totalTicks + fromNow;
 
-    DEBUG('i', "Scheduling interrupt handler the %s at time = %u\n",
+    DEBUG('i', "Scheduling interrupt handler the %s at time = %llu\n",
           INT_TYPE_NAMES[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(PendingInterrupt(handler, arg, when, type));
 }
 
 /// Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -287,34 +402,33 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
-    unsigned      when;
 
     ASSERT(level == INT_OFF);  // Interrupts need to be disabled, to invoke
                                // an interrupt handler.
     if (DebugIsEnabled('i'))
         DumpState();
-    PendingInterrupt *toOccur = pending->SortedRemove((int *) &when);
+    if (pending->IsEmpty())  // No pending interrupts.
+        return false;
 
-    if (toOccur == NULL)  // No pending interrupts.
-    return false;
+    PendingInterrupt toOccur = *pending->First();
+    unsigned long long when = toOccur.when;
 
     if (advanceClock && when > stats->totalTicks) {  // Advance the clock.
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
     } else if (when > stats->totalTicks) {  // Not time yet, put it back.
-        pending->SortedInsert(toOccur, when);
+        pending->Requeue();
         return false;
     }
 
     // Check if there is nothing more to do, and if so, quit.
-    if (status == IDLE_MODE && toOccur->type == TIMER_INT
-          && pending->IsEmpty()) {
-        pending->SortedInsert(toOccur, when);
+    if (status == IDLE_MODE && toOccur.type == TIMER_INT
+          && pending->Size() == 1)
         return false;
-    }
 
-    DEBUG('i', "Invoking interrupt handler for the %s at time %u\n",
-            INT_TYPE_NAMES[toOccur->type], toOccur->when);
+    pending->RemoveFirst();
+    DEBUG('i', "Invoking interrupt handler for the %s at time %llu\n",
+            INT_TYPE_NAMES[toOccur.type], toOccur.when);
 #ifdef USER_PROGRAM
     if (machine != NULL)
         machine->DelayedLoad(0, 0);
@@ -322,19 +436,18 @@ Interrupt::CheckIfDue(bool advanceClock)
     inHandler = true;
     status = SYSTEM_MODE;  // Whatever we were doing, we are now going to be
                            // running in the kernel.
-    (*toOccur->handler)(toOccur->arg);  // Call the interrupt handler.
+    (*toOccur.handler)(toOccur.arg);  // Call the interrupt handler.
     status = old;  // Restore the machine status.
     inHandler = false;
-    delete toOccur;
     return true;
 }
 
 /// Print information about an interrupt that is scheduled to occur.  When,
 /// where, why, etc.
 static void
-PrintPending(PendingInterrupt *pend)
+PrintPending(const PendingInterrupt *pend)
 {
-    printf("    Handler %s, scheduled at %u\n",
+    printf("    Handler %s, scheduled at %llu\n",
            INT_TYPE_NAMES[pend->type], pend->when);
 }
 
@@ -343,12 +456,16 @@ PrintPending(PendingInterrupt *pend)
 void
 Interrupt::DumpState()
 {
-    printf("Time: %u, interrupts %s\n",
+    printf("Time: %llu, interrupts %s\n",
            stats->totalTicks, INT_LEVEL_NAMES[level]);
     if (pending->IsEmpty())
         printf("No pending interrupts\n");
     else {
+        PendingInterrupt *pends = new PendingInterrupt[pending->Size()];
+        pending->Sorted(pends);
         printf("Pending interrupts:\n");
-        pending->Apply(PrintPending);
+        for (unsigned i = 0; i < pending->Size(); i++)
+            PrintPending(&pends[i]);
+        delete [] pends;
     }
 }
@@ -35,7 +35,7 @@
 #define NACHOS_MACHINE_INTERRUPT__HH
 
 
-#include "threads/list.hh"
+#include "threads/utility.hh"
 
 
 /// Interrupts can be disabled (`INT_OFF`) or enabled (`INT_ON`).
@@ -55,14 +55,17 @@ enum MachineStatus {
 
 /// `IntType` records which hardware device generated an interrupt.  In
 /// Nachos, we support a hardware timer device, a disk, a console display and
-/// keyboard, and a network.
+/// keyboard, and a network.  The kernel also schedules interrupts of its
+/// own to end timed waits and sleeps.
 enum IntType {
     TIMER_INT,
     DISK_INT,
     CONSOLE_WRITE_INT,
     CONSOLE_READ_INT,
     NETWORK_SEND_INT,
-    NETWORK_RECV_INT
+    NETWORK_RECV_INT,
+    TIMEOUT_INT,
+    ALARM_INT
 };
 
 /// The following class defines an interrupt that is scheduled to occur in
@@ -75,14 +78,88 @@ public:
 
     /// initialize an interrupt that will occur in the future.
     PendingInterrupt(VoidFunctionPtr func, void *param,
-                     unsigned time, IntType kind);
+                     unsigned long long time, IntType kind);
+
+    /// Initialize an empty slot of a `PendingQueue`.
+    PendingInterrupt() {}
 
     VoidFunctionPtr handler;  ///< The function (in the hardware device
                               ///< emulator) to call when the interrupt
                               ///< occurs.
     void *arg;  ///< The argument to the function.
-    unsigned when;  ///< When the interrupt is supposed to fire.
+    unsigned long long when;  ///< When the interrupt is supposed to fire.
     IntType type;  ///< For debugging.
+    unsigned long long order;  ///< Breaks ties between interrupts due at
+                               ///< the same time; the lowest fires first.
+};
+
+/// The interrupts scheduled to occur, kept in a binary min-heap ordered by
+/// time and then by order of arrival, so that the next one to fire can be
+/// looked at in constant time, and added or taken out in logarithmic time.
+///
+/// Interrupts are stored by value in an array that only grows, so that
+/// scheduling does not allocate memory once enough slots are in use.
+class PendingQueue {
+public:
+
+    /// Initialize an empty queue.
+    PendingQueue();
+
+    /// De-allocate the queue.
+    ~PendingQueue();
+
+    bool IsEmpty() const
+    {
+        return numPending == 0;
+    }
+
+    unsigned Size() const
+    {
+        return numPending;
+    }
+
+    /// The interrupt that fires first; the queue must not be empty.
+    const PendingInterrupt *First() const
+    {
+        return &heap[0];
+    }
+
+    /// Add `pend`, behind any other interrupt due at the same time.
+    void Insert(const PendingInterrupt &pend);
+
+    /// Take out the interrupt that fires first.
+    void RemoveFirst();
+
+    /// Move the interrupt that fires first behind any other interrupt due
+    /// at the same time, as if it was taken out and inserted again.
+    void Requeue();
+
+    /// Number of interrupts due at the same time as the first one.
+    unsigned CountTies() const;
+
+    /// Copy the interrupts into `pends`, which must have room for `Size()`
+    /// of them, in the order they will fire.
+    void Sorted(PendingInterrupt *pends) const;
+
+private:
+
+    /// Is `a` to fire before `b`?
+    static bool Before(const PendingInterrupt &a, const PendingInterrupt &b)
+    {
+        return a.when < b.when || (a.when == b.when && a.order < b.order);
+    }
+
+    void SiftUp(unsigned i);
+    void SiftDown(unsigned i);
+    unsigned CountTies(unsigned i) const;
+
+    PendingInterrupt *heap;
+    unsigned numPending;
+    unsigned maxPending;
+
+    /// Next value for `PendingInterrupt::order`.
+    unsigned long long arrivals;
+
 };
 
 /// The following class defines the data structures for the simulation
@@ -150,10 +227,17 @@ public:
     /// Advance simulated time.
     void OneTick();
 
+    /// Number of user ticks until the next pending interrupt is due.
+    unsigned TicksUntilDue();
+
+    /// Advance simulated time by several user ticks at once, none of which
+    /// may make an interrupt due.
+    void AdvanceUserTicks(unsigned ticks);
+
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
-    List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
-                                        ///< to occur in the future.
+    PendingQueue *pending;  ///< The interrupts scheduled to occur in the
+                            ///< future.
     bool inHandler;  ///< True if we are running an interrupt handler.
     bool yieldOnReturn;  ///< True if we are to context switch on return from
                          ///< the interrupt handler.
@@ -168,11 +252,6 @@ private:
     void ChangeLevel(IntStatus old,
                      IntStatus now);
 
-#ifdef DFS_TICKS_FIX
-    /// Restart total ticks and the pending interrupt list.
-    void RestartTicks();
-#endif
-
 };
 
 
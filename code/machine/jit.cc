@@ -0,0 +1,673 @@
+/// Routines to translate basic blocks of MIPS code into x86-64 code.
+///
+/// The generated code follows the System V calling convention.  While it
+/// runs:
+/// * `r15` points to the simulated registers;
+/// * `ebx` holds the virtual address of the first instruction of the block;
+/// * `r12d` holds the address a branch or jump will go to, once its delay
+///   slot is done;
+/// * `eax`, `ecx`, `edx`, `esi` and `edi` are scratch;
+/// * the word at the top of the stack receives values read from memory.
+///
+/// Every instruction that may fail jumps to an exit stub that sets the
+/// program counters as they would be before that instruction, and returns
+/// the number of instructions completed.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef HOST_x86_64
+
+#include "jit.hh"
+#include "encoding.hh"
+#include "machine.hh"
+#include "threads/system.hh"
+
+
+/// Size of the code buffer.
+static const unsigned CODE_SIZE = 4 << 20;
+
+/// Upper bound on the host code generated for a block.
+static const unsigned MAX_BLOCK_CODE = PAGE_SIZE / 4 * 128;
+
+// Host registers, by encoding.
+enum {
+    EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESI = 6, EDI = 7, R12 = 12, R15 = 15
+};
+
+// Host condition codes, by encoding.
+enum {
+    CC_O = 0x0, CC_B = 0x2, CC_E = 0x4, CC_NE = 0x5, CC_S = 0x8, CC_NS = 0x9,
+    CC_L = 0xC, CC_LE = 0xE, CC_G = 0xF
+};
+
+/// Read `size` bytes of user memory at `addr` into `*value`, as `ReadMem`
+/// does, but return 0 instead of raising an exception.  The interpreter
+/// raises it when it executes the instruction again.
+static int
+JitRead(unsigned addr, unsigned size, int *value)
+{
+    unsigned physAddr;
+
+    if (!machine->CachedTranslate(addr, &physAddr, size, false)
+          && machine->Translate(addr, &physAddr, size, false) != NO_EXCEPTION)
+        return 0;
+    return machine->ReadMem(addr, size, value);
+}
+
+/// Write `size` bytes of `value` into user memory at `addr`, as `WriteMem`
+/// does, but return 0 instead of raising an exception.
+///
+/// Returns 2 if the write hit physical page `frame`, where the running
+/// block comes from, since the rest of the block may have changed.
+static int
+JitWrite(unsigned addr, unsigned size, int value, unsigned frame)
+{
+    unsigned physAddr;
+
+    if (!machine->CachedTranslate(addr, &physAddr, size, true)
+          && machine->Translate(addr, &physAddr, size, true) != NO_EXCEPTION)
+        return 0;
+    machine->WriteMem(addr, size, value);
+    return physAddr / PAGE_SIZE == frame ? 2 : 1;
+}
+
+/// Return true if `instr` is a delayed load.
+static bool
+IsLoad(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_LB: case OP_LBU: case OP_LH: case OP_LHU: case OP_LW:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Writes x86-64 instructions into a buffer.
+class Emitter {
+public:
+
+    Emitter(unsigned char *start)
+    {
+        pos = start;
+    }
+
+    unsigned char *Position() const
+    {
+        return pos;
+    }
+
+    void Byte(unsigned b)
+    {
+        *pos++ = b;
+    }
+
+    void Word(unsigned w)
+    {
+        memcpy(pos, &w, 4);
+        pos += 4;
+    }
+
+    void Quad(unsigned long long q)
+    {
+        memcpy(pos, &q, 8);
+        pos += 8;
+    }
+
+    /// `op reg, [r15 + 4 * slot]` (or the other way around, depending on
+    /// `opcode`).  Two byte opcodes are given as `0x0Fxx`.
+    void RegMem(unsigned opcode, unsigned reg, unsigned slot)
+    {
+        Byte(reg >= 8 ? 0x45 : 0x41);
+        if (opcode > 0xFF)
+            Byte(opcode >> 8);
+        Byte(opcode & 0xFF);
+        Byte(0x80 | (reg & 7) << 3 | 7);
+        Word(slot * 4);
+    }
+
+    /// `mov reg, [r15 + 4 * slot]`.
+    void Load(unsigned reg, unsigned slot)
+    {
+        RegMem(0x8B, reg, slot);
+    }
+
+    /// `mov [r15 + 4 * slot], reg`.
+    void Store(unsigned slot, unsigned reg)
+    {
+        RegMem(0x89, reg, slot);
+    }
+
+    /// `mov dword [r15 + 4 * slot], imm`.
+    void StoreImm(unsigned slot, unsigned imm)
+    {
+        Byte(0x41);
+        Byte(0xC7);
+        Byte(0x87);
+        Word(slot * 4);
+        Word(imm);
+    }
+
+    /// Group 1 operation `ext` (add, or, and, sub, xor, cmp) of `reg` and
+    /// an immediate.
+    void RegImm(unsigned ext, unsigned reg, unsigned imm)
+    {
+        if (reg >= 8)
+            Byte(0x41);
+        Byte(0x81);
+        Byte(0xC0 | ext << 3 | (reg & 7));
+        Word(imm);
+    }
+
+    /// `mov reg, imm`.
+    void MovImm(unsigned reg, unsigned imm)
+    {
+        Byte(0xB8 + reg);
+        Word(imm);
+    }
+
+    /// `mov dst, src`, for 32 bit registers.
+    void Mov(unsigned dst, unsigned src)
+    {
+        if (dst >= 8 || src >= 8)
+            Byte(0x40 | (src >= 8 ? 4 : 0) | (dst >= 8 ? 1 : 0));
+        Byte(0x89);
+        Byte(0xC0 | (src & 7) << 3 | (dst & 7));
+    }
+
+    /// `lea reg, [rbx + disp]`.
+    void LeaPc(unsigned reg, int disp)
+    {
+        if (reg >= 8)
+            Byte(0x44);
+        Byte(0x8D);
+        Byte(0x80 | (reg & 7) << 3 | EBX);
+        Word(disp);
+    }
+
+    /// Shift group operation `ext` (shl, sar) of `eax` by `count`.
+    void ShiftImm(unsigned ext, unsigned count)
+    {
+        Byte(0xC1);
+        Byte(0xC0 | ext << 3 | EAX);
+        Byte(count);
+    }
+
+    /// Shift group operation `ext` of `eax` by `cl`.
+    void ShiftCl(unsigned ext)
+    {
+        Byte(0xD3);
+        Byte(0xC0 | ext << 3 | EAX);
+    }
+
+    /// `eax = cc ? 1 : 0`, from the flags.
+    void Set(unsigned cc)
+    {
+        Byte(0x0F);
+        Byte(0x90 | cc);
+        Byte(0xC0);  // setcc al
+        Byte(0x0F);
+        Byte(0xB6);
+        Byte(0xC0);  // movzx eax, al
+    }
+
+    /// `cmovcc r12d, ecx`.
+    void CmovTarget(unsigned cc)
+    {
+        Byte(0x44);
+        Byte(0x0F);
+        Byte(0x40 | cc);
+        Byte(0xC0 | (R12 & 7) << 3 | ECX);
+    }
+
+    /// `jcc rel32`; return where the displacement goes, to be patched.
+    unsigned char *Jump(unsigned cc)
+    {
+        Byte(0x0F);
+        Byte(0x80 | cc);
+        Word(0);
+        return pos - 4;
+    }
+
+    /// `jmp rel32`; return where the displacement goes.
+    unsigned char *Jump()
+    {
+        Byte(0xE9);
+        Word(0);
+        return pos - 4;
+    }
+
+    /// Make the jump whose displacement is at `at` land at `target`.
+    static void Patch(unsigned char *at, const unsigned char *target)
+    {
+        int disp = target - (at + 4);
+        memcpy(at, &disp, 4);
+    }
+
+    /// Call the C function at `func`.
+    void Call(const void *func)
+    {
+        Byte(0x48);
+        Byte(0xB8);
+        Quad((unsigned long long) func);  // mov rax, func
+        Byte(0xFF);
+        Byte(0xD0);  // call rax
+    }
+
+private:
+
+    unsigned char *pos;
+
+};
+
+/// Allocate the code buffer.  If the host refuses to hand out executable
+/// memory, nothing is ever translated.
+Jit::Jit()
+{
+    buffer = (unsigned char *) AllocExecutableArray(CODE_SIZE);
+    size   = buffer != NULL ? CODE_SIZE : 0;
+    used   = 0;
+}
+
+Jit::~Jit()
+{
+    if (buffer != NULL)
+        DeallocExecutableArray((char *) buffer, size);
+}
+
+void
+Jit::Reset()
+{
+    used = 0;
+}
+
+/// Emit the code that leaves the block with `done` instructions completed.
+///
+/// The registers already hold the result of those instructions, except for
+/// the program counters, which are set here.
+static void
+EmitExit(Emitter *e, const Block *block, unsigned done,
+         unsigned char **epilogue, unsigned *numJumps)
+{
+    if (done > 0) {
+        e->LeaPc(EAX, 4 * (done - 1));
+        e->Store(PREV_PC_REG, EAX);
+        if (done >= 2 && IsBranch(&block->code[done - 2])) {
+            // Just did a delay slot.
+            e->Store(PC_REG, R12);
+            e->Mov(EAX, R12);
+            e->RegImm(0, EAX, 4);
+            e->Store(NEXT_PC_REG, EAX);
+        } else if (IsBranch(&block->code[done - 1])) {
+            // The delay slot comes next.
+            e->LeaPc(EAX, 4 * done);
+            e->Store(PC_REG, EAX);
+            e->Store(NEXT_PC_REG, R12);
+        } else {
+            e->LeaPc(EAX, 4 * done);
+            e->Store(PC_REG, EAX);
+            e->LeaPc(EAX, 4 * done + 4);
+            e->Store(NEXT_PC_REG, EAX);
+        }
+    }
+    e->MovImm(EAX, done);
+    epilogue[(*numJumps)++] = e->Jump();
+}
+
+/// Emit the body of `instr`, the `index`-th instruction of the block.
+///
+/// Return false if it cannot be translated.  `exits[index]` collects the
+/// jumps taken when the instruction fails, and `exits[index + 1]` those
+/// taken when the block must be left right after it.
+static bool
+EmitInstruction(Emitter *e, const Instruction *instr, unsigned index,
+                const Block *block, unsigned char ***exits,
+                unsigned *numExits)
+{
+    int rs = instr->rs, rt = instr->rt, rd = instr->rd;
+    int extra = instr->extra;
+    int pc = 4 * index;  // Relative to the start of the block.
+
+    // Skip writes to R0; the interpreter clears it after every instruction.
+#define STORE(slot)  do { if ((slot) != 0) e->Store((slot), EAX); } while (0)
+#define FAIL(cc)     (exits[index][numExits[index]++] = e->Jump(cc))
+
+    switch (instr->opCode) {
+        case OP_ADD:  case OP_ADDU: case OP_SUB: case OP_SUBU:
+        case OP_AND:  case OP_OR:   case OP_XOR: case OP_NOR:
+        {
+            static const unsigned ops[] = {
+                0x03, 0x03, 0x2B, 0x2B, 0x23, 0x0B, 0x33, 0x0B
+            };
+            unsigned which = instr->opCode == OP_ADD  ? 0
+                           : instr->opCode == OP_ADDU ? 1
+                           : instr->opCode == OP_SUB  ? 2
+                           : instr->opCode == OP_SUBU ? 3
+                           : instr->opCode == OP_AND  ? 4
+                           : instr->opCode == OP_OR   ? 5
+                           : instr->opCode == OP_XOR  ? 6 : 7;
+            e->Load(EAX, rs);
+            e->RegMem(ops[which], EAX, rt);
+            if (instr->opCode == OP_ADD || instr->opCode == OP_SUB)
+                FAIL(CC_O);
+            if (instr->opCode == OP_NOR) {
+                e->Byte(0xF7);
+                e->Byte(0xD0);  // not eax
+            }
+            STORE(rd);
+            break;
+        }
+
+        case OP_ADDI:
+        case OP_ADDIU:
+            e->Load(EAX, rs);
+            e->RegImm(0, EAX, extra);
+            if (instr->opCode == OP_ADDI)
+                FAIL(CC_O);
+            STORE(rt);
+            break;
+
+        case OP_ANDI:
+        case OP_ORI:
+        case OP_XORI:
+            e->Load(EAX, rs);
+            e->RegImm(instr->opCode == OP_ANDI ? 4
+                      : instr->opCode == OP_ORI ? 1 : 6, EAX, extra & 0xFFFF);
+            STORE(rt);
+            break;
+
+        case OP_LUI:
+            if (rt != 0)
+                e->StoreImm(rt, extra << 16);
+            break;
+
+        case OP_SLL:
+        case OP_SRA:
+        case OP_SRL:
+            // The interpreter shifts right logically through a signed
+            // integer, so both right shifts are arithmetic.  Keep it that
+            // way.
+            e->Load(EAX, rt);
+            e->ShiftImm(instr->opCode == OP_SLL ? 4 : 7, extra);
+            STORE(rd);
+            break;
+
+        case OP_SLLV:
+        case OP_SRAV:
+        case OP_SRLV:
+            e->Load(EAX, rt);
+            e->Load(ECX, rs);
+            e->ShiftCl(instr->opCode == OP_SLLV ? 4 : 7);
+            STORE(rd);
+            break;
+
+        case OP_SLT:
+        case OP_SLTU:
+            e->Load(EAX, rs);
+            e->RegMem(0x3B, EAX, rt);
+            e->Set(instr->opCode == OP_SLT ? CC_L : CC_B);
+            STORE(rd);
+            break;
+
+        case OP_SLTI:
+        case OP_SLTIU:
+            e->Load(EAX, rs);
+            e->RegImm(7, EAX, extra);
+            e->Set(instr->opCode == OP_SLTI ? CC_L : CC_B);
+            STORE(rt);
+            break;
+
+        case OP_MFHI:
+        case OP_MFLO:
+            e->Load(EAX, instr->opCode == OP_MFHI ? HI_REG : LO_REG);
+            STORE(rd);
+            break;
+
+        case OP_MTHI:
+        case OP_MTLO:
+            e->Load(EAX, rs);
+            e->Store(instr->opCode == OP_MTHI ? HI_REG : LO_REG, EAX);
+            break;
+
+        case OP_MULT:
+        case OP_MULTU:
+            if (instr->opCode == OP_MULT) {
+                e->Byte(0x49);
+                e->Byte(0x63);
+                e->Byte(0x87);
+                e->Word(rs * 4);  // movsxd rax, [rs]
+                e->Byte(0x49);
+                e->Byte(0x63);
+                e->Byte(0x8F);
+                e->Word(rt * 4);  // movsxd rcx, [rt]
+            } else {
+                e->Load(EAX, rs);
+                e->Load(ECX, rt);
+            }
+            e->Byte(0x48);
+            e->Byte(0x0F);
+            e->Byte(0xAF);
+            e->Byte(0xC1);  // imul rax, rcx
+            e->Store(LO_REG, EAX);
+            e->Byte(0x48);
+            e->Byte(0xC1);
+            e->Byte(0xE8);
+            e->Byte(32);    // shr rax, 32
+            e->Store(HI_REG, EAX);
+            break;
+
+        case OP_LB: case OP_LBU: case OP_LH: case OP_LHU: case OP_LW:
+        {
+            unsigned size = instr->opCode == OP_LW ? 4
+                          : instr->opCode == OP_LH
+                            || instr->opCode == OP_LHU ? 2 : 1;
+            e->Load(EDI, rs);
+            e->RegImm(0, EDI, extra);
+            e->MovImm(ESI, size);
+            e->Byte(0x48);
+            e->Byte(0x89);
+            e->Byte(0xE2);  // mov rdx, rsp
+            e->Call((const void *) JitRead);
+            e->Byte(0x85);
+            e->Byte(0xC0);  // test eax, eax
+            FAIL(CC_E);
+            e->Byte(0x8B);
+            e->Byte(0x04);
+            e->Byte(0x24);  // mov eax, [rsp]
+            if (instr->opCode != OP_LW) {
+                e->Byte(0x0F);
+                e->Byte(instr->opCode == OP_LB  ? 0xBE
+                        : instr->opCode == OP_LBU ? 0xB6
+                        : instr->opCode == OP_LH  ? 0xBF : 0xB7);
+                e->Byte(0xC0);  // movsx/movzx eax, al/ax
+            }
+            e->Mov(ESI, EAX);  // Becomes the pending load value.
+            break;
+        }
+
+        case OP_SB: case OP_SH: case OP_SW:
+            e->Load(EDI, rs);
+            e->RegImm(0, EDI, extra);
+            e->MovImm(ESI, instr->opCode == OP_SW ? 4
+                           : instr->opCode == OP_SH ? 2 : 1);
+            e->Load(EDX, rt);
+            e->MovImm(ECX, block->physAddr / PAGE_SIZE);
+            e->Call((const void *) JitWrite);
+            e->Byte(0x85);
+            e->Byte(0xC0);  // test eax, eax
+            FAIL(CC_E);
+            e->Mov(ESI, EAX);  // Checked once the instruction is done.
+            break;
+
+        case OP_BEQ: case OP_BNE: case OP_BGTZ: case OP_BLEZ:
+        case OP_BGEZ: case OP_BLTZ: case OP_BGEZAL: case OP_BLTZAL:
+        {
+            unsigned cc;
+            if (instr->opCode == OP_BGEZAL || instr->opCode == OP_BLTZAL) {
+                e->LeaPc(EAX, pc + 8);
+                e->Store(R31, EAX);
+            }
+            e->LeaPc(R12, pc + 8);
+            e->Load(EAX, rs);
+            if (instr->opCode == OP_BEQ || instr->opCode == OP_BNE) {
+                e->RegMem(0x3B, EAX, rt);
+                cc = instr->opCode == OP_BEQ ? CC_E : CC_NE;
+            } else {
+                e->Byte(0x85);
+                e->Byte(0xC0);  // test eax, eax
+                cc = instr->opCode == OP_BGTZ ? CC_G
+                   : instr->opCode == OP_BLEZ ? CC_LE
+                   : instr->opCode == OP_BLTZ
+                     || instr->opCode == OP_BLTZAL ? CC_S : CC_NS;
+            }
+            e->LeaPc(ECX, pc + 4 + IndexToAddr(extra));
+            e->CmovTarget(cc);
+            break;
+        }
+
+        case OP_J:
+        case OP_JAL:
+            if (instr->opCode == OP_JAL) {
+                e->LeaPc(EAX, pc + 8);
+                e->Store(R31, EAX);
+            }
+            e->LeaPc(R12, pc + 8);
+            e->RegImm(4, R12, 0xF0000000);
+            e->RegImm(1, R12, IndexToAddr(extra));
+            break;
+
+        case OP_JALR:
+            if (rd == 0)
+                return false;
+            e->LeaPc(EAX, pc + 8);
+            e->Store(rd, EAX);
+            e->Load(R12, rs);
+            break;
+
+        case OP_JR:
+            e->Load(R12, rs);
+            break;
+
+        default:
+            return false;
+    }
+#undef STORE
+#undef FAIL
+    return true;
+}
+
+/// Emit what the interpreter does after every instruction: apply the
+/// pending delayed load, and record the one `instr` starts, if any.
+static void
+EmitDelayedLoad(Emitter *e, const Block *block, unsigned index)
+{
+    const Instruction *instr = &block->code[index];
+    bool prevLoad = index > 0 && IsLoad(&block->code[index - 1]);
+
+    if (index == 0) {
+        // Whatever was pending when the block was entered.
+        e->Load(EAX, LOAD_REG);
+        e->Load(EDX, LOAD_VALUE_REG);
+        e->Byte(0x41);
+        e->Byte(0x89);
+        e->Byte(0x14);
+        e->Byte(0x87);  // mov [r15 + 4 * rax], edx
+        e->StoreImm(0, 0);
+    } else if (prevLoad && block->code[index - 1].rt != 0) {
+        e->Load(EAX, LOAD_VALUE_REG);
+        e->Store(block->code[index - 1].rt, EAX);
+    }
+
+    if (IsLoad(instr)) {
+        e->StoreImm(LOAD_REG, instr->rt);
+        e->Store(LOAD_VALUE_REG, ESI);
+    } else if (index == 0 || prevLoad) {
+        e->StoreImm(LOAD_REG, 0);
+        e->StoreImm(LOAD_VALUE_REG, 0);
+    }
+}
+
+/// Translate as many instructions of `block` as possible.
+bool
+Jit::Compile(Block *block)
+{
+    if (size - used < MAX_BLOCK_CODE)
+        return false;
+
+    unsigned char *start = buffer + used;
+    Emitter        e(start);
+
+    // Jumps to be patched: to the exit of each instruction, and to the
+    // common epilogue.
+    unsigned char **exits[PAGE_SIZE / 4 + 1];
+    unsigned        numExits[PAGE_SIZE / 4 + 1];
+    unsigned char  *storage[PAGE_SIZE / 4 + 1][4];
+    unsigned char  *epilogue[PAGE_SIZE / 4 + 2];
+    unsigned        numEpilogue = 0;
+    for (unsigned i = 0; i <= block->length; i++) {
+        exits[i]    = storage[i];
+        numExits[i] = 0;
+    }
+
+    e.Byte(0x53);                                // push rbx
+    e.Byte(0x41); e.Byte(0x54);                  // push r12
+    e.Byte(0x41); e.Byte(0x57);                  // push r15
+    e.Byte(0x48); e.Byte(0x83); e.Byte(0xEC);
+    e.Byte(0x10);                                // sub rsp, 16
+    e.Byte(0x49); e.Byte(0x89); e.Byte(0xFF);    // mov r15, rdi
+    e.Load(EBX, PC_REG);
+
+    unsigned length = 0;
+    for (unsigned i = 0; i < block->length; i++) {
+        const Instruction *instr = &block->code[i];
+        if (i > 0 && IsBranch(instr) && IsBranch(&block->code[i - 1]))
+            break;  // A branch in a delay slot; leave it to the
+                    // interpreter.
+        if (!EmitInstruction(&e, instr, i, block, exits, numExits))
+            break;
+        EmitDelayedLoad(&e, block, i);
+        if (instr->opCode == OP_SB || instr->opCode == OP_SH
+              || instr->opCode == OP_SW) {
+            e.Byte(0x83);
+            e.Byte(0xFE);
+            e.Byte(0x02);  // cmp esi, 2
+            exits[i + 1][numExits[i + 1]++] = e.Jump(CC_E);
+        }
+        length = i + 1;
+    }
+    if (length == 0) {
+        block->native = NULL;
+        return true;
+    }
+
+    // Falling off the end of the translated code.
+    EmitExit(&e, block, length, epilogue, &numEpilogue);
+
+    // Exits taken from the middle.
+    for (unsigned i = 0; i <= length; i++) {
+        if (numExits[i] == 0)
+            continue;
+        for (unsigned j = 0; j < numExits[i]; j++)
+            Emitter::Patch(exits[i][j], e.Position());
+        EmitExit(&e, block, i, epilogue, &numEpilogue);
+    }
+
+    for (unsigned j = 0; j < numEpilogue; j++)
+        Emitter::Patch(epilogue[j], e.Position());
+    e.Byte(0x48); e.Byte(0x83); e.Byte(0xC4); e.Byte(0x10);  // add rsp, 16
+    e.Byte(0x41); e.Byte(0x5F);                              // pop r15
+    e.Byte(0x41); e.Byte(0x5C);                              // pop r12
+    e.Byte(0x5B);                                            // pop rbx
+    e.Byte(0xC3);                                            // ret
+
+    ASSERT((unsigned) (e.Position() - start) <= MAX_BLOCK_CODE);
+    used += e.Position() - start;
+    block->native       = (NativeCode) start;
+    block->nativeLength = length;
+    return true;
+}
+
+#endif
@@ -0,0 +1,65 @@
+/// Data structures for translating user code into host machine code.
+///
+/// This is an optional execution engine for user programs, selected with
+/// the `-j` flag, and only available when the host is an x86-64.  Basic
+/// blocks that have been entered often enough are translated into host
+/// code; the rest of the time, and for anything the translator does not
+/// handle, the interpreter in `mips_sim.cc` is used.
+///
+/// Translated code keeps all the simulated state in `Machine::registers`,
+/// exactly as the interpreter would leave it after every instruction,
+/// including the delayed load registers.  This allows it to stop before any
+/// instruction (for example, one that would raise an exception) and let the
+/// interpreter take over from there.  Memory is accessed through helper
+/// routines that go through `Machine::Translate`.
+///
+/// The following instructions are not translated: divisions, unaligned
+/// loads and stores, system calls and reserved instructions.  A block is
+/// translated up to the first of them.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_JIT__HH
+#define NACHOS_MACHINE_JIT__HH
+
+
+#include "block_cache.hh"
+
+
+/// Number of times a block has to be entered before it is translated.
+const unsigned JIT_THRESHOLD = 8;
+
+class Jit {
+public:
+
+    /// Allocate the code buffer.
+    Jit();
+
+    /// De-allocate the code buffer.
+    ~Jit();
+
+    /// Translate `block` into host code.
+    ///
+    /// Sets `block->native` and `block->nativeLength`, or leaves `native`
+    /// as NULL if not even the first instruction can be translated.  Returns
+    /// false if the code buffer is full.
+    bool Compile(Block *block);
+
+    /// Discard all the host code generated so far.
+    void Reset();
+
+private:
+
+    /// Where host code is stored.
+    unsigned char *buffer;
+
+    /// Size of the buffer, and how much of it is in use.
+    unsigned size;
+    unsigned used;
+
+};
+
+
+#endif
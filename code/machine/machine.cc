@@ -9,8 +9,13 @@
 
 
 #include "machine.hh"
+#include "jit.hh"
+#include "profile.hh"
 #include "threads/system.hh"
 
+#include <limits.h>
+#include <string.h>
+
 
 /// Textual names of the exceptions that can be generated by user program
 /// execution, for debugging.
@@ -45,18 +50,29 @@ CheckEndian()
 ///
 /// * `debug` -- if true, drop into the debugger after each user instruction
 ///   is executed.
-Machine::Machine(bool debug)
+/// * `translate` -- if true, translate hot user code into host code, when
+///   the host allows it.  Not done while tracing instructions, memory
+///   accesses or interrupts, since translated code does not print them.
+/// * `physPages` is the number of pages of physical memory.
+/// * `tlbEntries` is the number of entries in the TLB, if there is one.
+Machine::Machine(bool debug, bool translate,
+                 unsigned physPages, unsigned tlbEntries)
 {
+    ASSERT(physPages > 0 && physPages <= UINT_MAX / PAGE_SIZE);
+    ASSERT(tlbEntries > 0);
+    numPhysPages = physPages;
+    memorySize   = numPhysPages * PAGE_SIZE;
+    tlbSize      = tlbEntries;
+
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
         registers[i] = 0;
 
-    mainMemory = new char[MEMORY_SIZE];
-    for (unsigned i = 0; i < MEMORY_SIZE; i++)
-          mainMemory[i] = 0;
+    mainMemory = new char[memorySize];
+    memset(mainMemory, 0, memorySize);
 
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLB_SIZE];
-    for (unsigned i = 0; i < TLB_SIZE; i++)
+    tlb = new TranslationEntry[tlbSize];
+    for (unsigned i = 0; i < tlbSize; i++)
         tlb[i].valid = false;
     pageTable = NULL;
 #else  // Use linear page table.
@@ -64,6 +80,20 @@ Machine::Machine(bool debug)
     pageTable = NULL;
 #endif
 
+    decodeCache = new DecodeCache(numPhysPages, PAGE_SIZE);
+    blockCache  = new BlockCache(decodeCache, numPhysPages, PAGE_SIZE);
+    cacheTranslations = !DebugIsEnabled('a');
+    FlushTranslationCache();
+    unchargedTicks = 0;
+    batchTicks = !DebugIsEnabled('i');
+    profile = NULL;
+    jit = NULL;
+#ifdef HOST_x86_64
+    if (translate && !DebugIsEnabled('m') && !DebugIsEnabled('a')
+          && !DebugIsEnabled('i'))
+        jit = new Jit;
+#endif
+
     singleStep = debug;
     CheckEndian();
 }
@@ -74,6 +104,31 @@ Machine::~Machine()
     delete [] mainMemory;
     if (tlb != NULL)
         delete [] tlb;
+#ifdef HOST_x86_64
+    delete jit;
+#endif
+    delete profile;
+    delete blockCache;
+    delete decodeCache;
+}
+
+void
+Machine::StartProfile()
+{
+    if (profile != NULL)
+        return;
+    profile = new Profile;
+#ifdef HOST_x86_64
+    delete jit;
+#endif
+    jit = NULL;
+}
+
+void
+Machine::PrintProfile()
+{
+    if (profile != NULL)
+        profile->Print();
 }
 
 /// Transfer control to the Nachos kernel from user mode, because the user
@@ -87,14 +142,42 @@ Machine::RaiseException(ExceptionType which, unsigned badVAddr)
 {
     DEBUG('m', "Exception: %s\n", EXCEPTION_NAMES[which]);
 
+    ChargeTicks();  // The kernel must see the right time.
     //ASSERT(interrupt->getStatus() == USER_MODE);
     registers[BAD_VADDR_REG] = badVAddr;
     DelayedLoad(0, 0);  // Finish anything in progress.
     interrupt->setStatus(SYSTEM_MODE);
+    FlushTranslationCache();  // The kernel may change the mappings.
     ExceptionHandler(which);  // Interrupts are enabled at this point.
     interrupt->setStatus(USER_MODE);
 }
 
+/// Forget any decoded instruction or basic block coming from physical page
+/// `frame`, because its contents are about to change behind the simulator's
+/// back.
+void
+Machine::InvalidateFrame(unsigned frame)
+{
+    ASSERT(frame < numPhysPages);
+    decodeCache->InvalidateFrame(frame);
+    blockCache->InvalidateFrame(frame);
+}
+
+/// Forget how virtual addresses were translated, because the page table or
+/// the TLB is about to change.
+///
+/// Besides the translation cache itself, the links between basic blocks
+/// depend on the translation; the blocks themselves are kept.
+void
+Machine::FlushTranslationCache()
+{
+    for (unsigned i = 0; i < TRANSLATION_CACHE_SIZE; i++) {
+        translationCache[i].readable = false;
+        translationCache[i].writable = false;
+    }
+    blockCache->Unlink();
+}
+
 const int *
 Machine::GetRegisters() const
 {
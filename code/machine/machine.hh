@@ -21,19 +21,29 @@
 #define NACHOS_MACHINE_MACHINE__HH
 
 
+#include "block_cache.hh"
 #include "disk.hh"
 #include "translation_entry.hh"
 #include "threads/utility.hh"
 
 
+class Jit;
+class Profile;
+
 /// Definitions related to the size, and format of user memory.
 
 const unsigned PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal to the
                                          ///< disk sector size, for
                                          ///< simplicity.
-const unsigned NUM_PHYS_PAGES = 32;
-const unsigned MEMORY_SIZE = NUM_PHYS_PAGES * PAGE_SIZE;
-const unsigned TLB_SIZE = 4;  ///< if there is a TLB, make it small.
+
+/// Number of physical pages and of TLB entries, unless others are given in
+/// the command line.
+const unsigned DEFAULT_NUM_PHYS_PAGES = 32;
+const unsigned DEFAULT_TLB_SIZE = 4;  ///< if there is a TLB, make it small.
+
+/// Number of entries in the simulator's own cache of translations.  Must be
+/// a power of two.
+const unsigned TRANSLATION_CACHE_SIZE = 64;
 
 enum ExceptionType {
     NO_EXCEPTION,             // Everything ok!
@@ -68,7 +78,20 @@ enum ExceptionType {
 #define NUM_GP_REGS     32  ///< 32 general purpose registers on MIPS.
 #define NUM_TOTAL_REGS  40
 
-class Instruction;
+/// A translation remembered by the simulator, so that memory accesses to a
+/// page already translated do not need to go through `Machine::Translate`.
+///
+/// This is invisible to the kernel: it is a cache of the page table or TLB
+/// entry, keyed by virtual page number, with the permissions the entry
+/// grants.
+struct CachedTranslation {
+    unsigned vpn;             ///< Virtual page number.
+    char *host;               ///< Where the page starts in `mainMemory`.
+    TranslationEntry *entry;  ///< Page table or TLB entry it comes from,
+                              ///< whose `use` and `dirty` bits are kept.
+    bool readable;            ///< May be used for reading.
+    bool writable;            ///< May be used for writing.
+};
 
 /// The following class defines the simulated host workstation hardware, as
 /// seen by user programs -- the CPU registers, main memory, etc.
@@ -87,7 +110,9 @@ class Machine {
 public:
 
     /// Initialize the simulation of the hardware for running user programs.
-    Machine(bool debug);
+    Machine(bool debug, bool translate,
+            unsigned physPages = DEFAULT_NUM_PHYS_PAGES,
+            unsigned tlbEntries = DEFAULT_TLB_SIZE);
 
     /// De-allocate the data structures.
     ~Machine();
@@ -105,10 +130,69 @@ public:
     /// store a value into a CPU register.
     void WriteRegister(unsigned num, int value);
 
+    /// Size of the simulated hardware: number of physical pages, bytes of
+    /// physical memory, and entries in the TLB.
+    unsigned GetNumPhysPages() const
+    {
+        return numPhysPages;
+    }
+
+    unsigned GetMemorySize() const
+    {
+        return memorySize;
+    }
+
+    unsigned GetTlbSize() const
+    {
+        return tlbSize;
+    }
+
+    /// Copy `size` bytes between user virtual memory at `virtAddr` and the
+    /// kernel's `buffer`, translating only once per page.  Return false if
+    /// some page could not be translated, even after giving the kernel a
+    /// chance to bring it in.
+    bool CopyFromUser(unsigned virtAddr, char *buffer, unsigned size);
+    bool CopyToUser(unsigned virtAddr, const char *buffer, unsigned size);
+
+    /// Like `CopyFromUser`, but stop after copying a null character.
+    bool CopyStringFromUser(unsigned virtAddr, char *buffer,
+                            unsigned maxSize);
+
+    /// Start counting, for every user instruction, how many times it runs
+    /// and how many TLB misses and page faults it causes.  Host code
+    /// translation is turned off, so that every instruction is counted.
+    void StartProfile();
+
+    /// Print the profile, if one is being kept.
+    void PrintProfile();
+
     /// Routines internal to the machine simulation -- DO NOT call these.
 
     /// Run one instruction of a user program.
-    void OneInstruction(Instruction *instr);
+    void OneInstruction();
+
+    /// Run user instructions a basic block at a time, until something
+    /// forces the simulator back into `Run`.
+    void RunBlocks();
+
+    /// Execute the already fetched instruction `instr`.  Return false if it
+    /// raised an exception.
+    bool ExecuteInstruction(const Instruction *instr);
+
+    /// Run the host code translated from `block`, if possible without
+    /// going past `limit` instructions, and return how many of its
+    /// instructions were executed.
+    unsigned RunNative(Block *block, unsigned limit);
+
+    /// Number of user instructions that can run before the clock must be
+    /// ticked for real.
+    unsigned NextDeadline();
+
+    /// Charge the ticks of the instructions run since the last tick,
+    /// before the deadline or at it.
+    void ChargeTicks();
+    void TickAtDeadline();
+
     /// Do a pending delayed load (modifying a reg).
     void DelayedLoad(unsigned nextReg, int nextVal);
 
@@ -127,10 +211,36 @@ public:
     ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
                             unsigned size, bool writing);
 
+    /// Translate an address using only the translations cached by the
+    /// simulator.  Return false if the slow path through `Translate` has to
+    /// be taken.
+    bool CachedTranslate(unsigned virtAddr, unsigned *physAddr,
+                         unsigned size, bool writing);
+
+    /// Translate an address on behalf of the kernel, which is going to copy
+    /// data to or from user memory, faulting the page in if needed.
+    bool TranslateForCopy(unsigned virtAddr, unsigned *physAddr,
+                          bool writing);
+
     /// Trap to the Nachos kernel, because of a system call or other
     /// exception.
     void RaiseException(ExceptionType which, unsigned badVAddr);
 
+    /// Discard anything the simulator has cached about the contents of
+    /// physical page `frame`.
+    ///
+    /// The kernel must call this whenever it writes into a frame directly
+    /// through `mainMemory` (for example when loading a program), or
+    /// reassigns it to another virtual page.
+    void InvalidateFrame(unsigned frame);
+
+    /// Discard every virtual to physical translation the simulator may
+    /// have cached.
+    ///
+    /// Must be called whenever the page table in use or the contents of
+    /// the TLB change.
+    void FlushTranslationCache();
+
     /// print the user CPU and memory state.
     void DumpState();
 
@@ -171,9 +281,38 @@ public:
     TranslationEntry *pageTable;
     unsigned pageTableSize;
 
+    Profile *profile;  ///< Counts by instruction, or NULL if user programs
+                       ///< are not being profiled.
+
   private:
     bool singleStep;  ///< Drop back into the debugger after each simulated
                       ///< instruction.
+
+    unsigned numPhysPages;  ///< Number of pages of physical memory.
+    unsigned memorySize;    ///< Bytes of physical memory.
+    unsigned tlbSize;       ///< Number of entries in the TLB.
+
+    DecodeCache *decodeCache;  ///< Already decoded instructions, by
+                               ///< physical address.
+
+    BlockCache *blockCache;  ///< Basic blocks formed from the decoded
+                             ///< instructions.
+
+    Jit *jit;  ///< Translator of blocks into host code, or NULL if user
+               ///< programs are only interpreted.
+
+    /// Translations recently done by `Translate`, indexed by virtual page
+    /// number.  Left empty while memory accesses are being traced.
+    CachedTranslation translationCache[TRANSLATION_CACHE_SIZE];
+    bool cacheTranslations;
+
+    /// User instructions executed by `RunBlocks` whose ticks have not been
+    /// added to the clock yet.
+    unsigned unchargedTicks;
+
+    /// Whether ticks may be charged in bulk; not while interrupts are being
+    /// traced.
+    bool batchTicks;
 };
 
 extern void ExceptionHandler(ExceptionType which);
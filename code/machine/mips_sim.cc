@@ -13,7 +13,10 @@
 
 #include "debugger.hh"
 #include "instruction.hh"
+#include "jit.hh"
+#include "profile.hh"
 #include "machine.hh"
+#include "threads/preemptive.hh"
 #include "threads/system.hh"
 
 
@@ -25,24 +28,190 @@ static void Mult(int a, int b, bool signedArith, int *hiPtr, int *loPtr);
 ///
 /// This routine is re-entrant, in that it can be called multiple times
 /// concurrently -- one for each thread executing user code.
+///
+/// When the time slice of the preemptive scheduler ends, the thread yields
+/// here, between instructions or blocks, with every tick charged.
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;
-      // Storage for decoded instruction.
-
     if (DebugIsEnabled('m'))
-        printf("Starting thread \"%s\" at time %u\n",
+        printf("Starting thread \"%s\" at time %llu\n",
                currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(USER_MODE);
 
     Debugger *d = singleStep ? new Debugger : NULL;
     for (;;) {
-        OneInstruction(instr);
-        interrupt->OneTick();
-        if (singleStep)
+        if (singleStep) {
+            OneInstruction();
+            interrupt->OneTick();
             singleStep = d->Debug();
+        } else
+            RunBlocks();
+
+        if (preemptionRequested) {
+            preemptionRequested = false;
+            interrupt->setStatus(SYSTEM_MODE);  // Yield is a kernel routine.
+            currentThread->Yield();
+            interrupt->setStatus(USER_MODE);
+        }
+    }
+}
+
+/// Execute user instructions a basic block at a time.
+///
+/// The program counter is only translated when entering a block that is
+/// not linked to the previous one; then the block is found (or formed) in
+/// the block cache by physical address, and linked.
+///
+/// The clock is not ticked after every instruction, as in `Run`.  Instead,
+/// the number of ticks until the next interrupt is due is computed once,
+/// and instructions are only counted in `unchargedTicks` until that
+/// deadline is reached; the last one is followed by a real `OneTick`, so
+/// that interrupts still happen at the same points of the program.  The
+/// ticks counted are charged before anything else can look at the clock:
+/// at the deadline, when an exception is raised, and when returning.
+///
+/// Return after an exception, when the translation may have changed during
+/// a tick (the epoch of the block cache changed), so that `Run` can start
+/// over from the registers, or when the preemptive scheduler asks for a
+/// yield.
+void
+Machine::RunBlocks()
+{
+    unsigned epoch = blockCache->Epoch();
+    unsigned deadline = NextDeadline();
+    Block   *previous = NULL;
+
+    ASSERT(unchargedTicks == 0);
+    for (;;) {
+        if (preemptionRequested) {
+            ChargeTicks();
+            return;
+        }
+
+        int    pc = registers[PC_REG];
+        Block *block = previous != NULL ? previous->Successor(pc, epoch)
+                                        : NULL;
+        if (block == NULL) {
+            unsigned physAddr;
+            if (!CachedTranslate(pc, &physAddr, 4, false)) {
+                ExceptionType exception = Translate(pc, &physAddr, 4, false);
+                if (exception != NO_EXCEPTION) {
+                    RaiseException(exception, pc);
+                    interrupt->OneTick();
+                    return;
+                }
+            }
+            block = blockCache->Find(mainMemory, physAddr);
+            if (previous != NULL)
+                previous->Link(pc, block, epoch);
+        }
+
+        unsigned i = 0;
+        if (jit != NULL) {
+            i = RunNative(block, deadline - unchargedTicks);
+            unchargedTicks += i;
+            if (unchargedTicks == deadline) {
+                TickAtDeadline();
+                deadline = NextDeadline();
+            }
+            if (blockCache->Epoch() != epoch) {
+                ChargeTicks();
+                return;
+            }
+        }
+        for (; i < block->length; i++) {
+            if (registers[PC_REG] != pc + (int) (4 * i))
+                break;  // Entered the block on a delay slot; leave it.
+            if (profile != NULL)
+                profile->CountInstruction(pc + 4 * i);
+            if (!ExecuteInstruction(&block->code[i])) {
+                interrupt->OneTick();  // The others were charged already.
+                return;
+            }
+            if (++unchargedTicks == deadline) {
+                TickAtDeadline();
+                deadline = NextDeadline();
+            }
+            if (blockCache->Epoch() != epoch) {
+                ChargeTicks();
+                return;
+            }
+        }
+        previous = block;
+    }
+}
+
+/// Return how many user instructions may run before the clock has to be
+/// ticked for real, counting from the last tick charged.
+///
+/// While interrupts are being traced, every tick is made for real, so that
+/// the trace shows each of them.
+unsigned
+Machine::NextDeadline()
+{
+    return batchTicks ? interrupt->TicksUntilDue() : 1;
+}
+
+/// Charge the ticks of the instructions counted in `unchargedTicks`,
+/// which must not have reached the deadline, so that no interrupt can be
+/// due yet.
+void
+Machine::ChargeTicks()
+{
+    interrupt->AdvanceUserTicks(unchargedTicks);
+    unchargedTicks = 0;
+}
+
+/// Charge the ticks of the instructions counted in `unchargedTicks`, the
+/// last of which reached the deadline.
+///
+/// All of them but the last are charged in bulk; the last one ticks the
+/// clock through `OneTick`, which may run interrupt handlers and switch to
+/// another thread.
+void
+Machine::TickAtDeadline()
+{
+    interrupt->AdvanceUserTicks(unchargedTicks - 1);
+    unchargedTicks = 0;
+    interrupt->OneTick();
+}
+
+/// Run the host code of `block`, translating it first if it just became
+/// hot.
+///
+/// The host code is only run if it cannot go past `limit` instructions,
+/// the number left until the deadline, so that the clock can be advanced in
+/// bulk afterwards and still match, tick by tick, what the interpreter
+/// would have done.  It must also start with the program counters in sequence, as
+/// it assumes it is not entered on a delay slot.
+///
+/// Returns the number of instructions executed, whose ticks are left for
+/// the caller to charge; the interpreter must go on from there.
+unsigned
+Machine::RunNative(Block *block, unsigned limit)
+{
+#ifdef HOST_x86_64
+    if (block->native == NULL) {
+        if (++block->hits != JIT_THRESHOLD)
+            return 0;
+        if (!jit->Compile(block)) {  // Out of space; start over.
+            blockCache->ForgetNative();
+            jit->Reset();
+            if (!jit->Compile(block))
+                return 0;
+        }
+        if (block->native == NULL)
+            return 0;
     }
+
+    if (registers[NEXT_PC_REG] != registers[PC_REG] + 4
+          || block->nativeLength > limit)
+        return 0;
+    return block->native(registers);
+#else
+    return 0;
+#endif
 }
 
 /// Execute one instruction from a user-level program.
@@ -62,20 +231,39 @@ Machine::Run()
 /// all data back to the machine registers and memory before leaving.  This
 /// allows the Nachos kernel to control our behavior by controlling the
 /// contents of memory, the translation table, and the register set.
+///
+/// The only thing kept across calls is the decode cache, which is indexed by
+/// physical address and thus does not depend on the translation in effect.
 void
-Machine::OneInstruction(Instruction *instr)
+Machine::OneInstruction()
+{
+    // Fetch instruction.  Decoding is done only the first time a word is
+    // fetched; after that, the decode cache hands back the ready-made
+    // record.
+    unsigned      physAddr;
+    ExceptionType exception = Translate(registers[PC_REG], &physAddr,
+                                        4, false);
+    if (exception != NO_EXCEPTION) {
+        RaiseException(exception, registers[PC_REG]);
+        return;  // Exception occurred.
+    }
+    if (profile != NULL)
+        profile->CountInstruction(registers[PC_REG]);
+    ExecuteInstruction(decodeCache->Fetch(mainMemory, physAddr));
+}
+
+/// Execute an instruction that has already been fetched and decoded.
+///
+/// On success, apply the pending delayed load and advance the program
+/// counters.  Return false if an exception was raised instead; the program
+/// counters are then left untouched.
+bool
+Machine::ExecuteInstruction(const Instruction *instr)
 {
-    int raw;
     int nextLoadReg = 0;
     int nextLoadValue = 0;  // Record delayed load operation, to apply in the
                             // future.
 
-    // Fetch instruction.
-    if (!machine->ReadMem(registers[PC_REG], 4, &raw))
-        return;  // Exception occurred.
-    instr->value = raw;
-    instr->Decode();
-
     if (DebugIsEnabled('m')) {
         const struct OpString *str = &OP_STRINGS[(int) instr->opCode];
 
@@ -102,7 +290,7 @@ Machine::OneInstruction(Instruction *instr)
                     & SIGN_BIT)
                   && ((registers[(int) instr->rs] ^ sum) & SIGN_BIT)) {
                 RaiseException(OVERFLOW_EXCEPTION, 0);
-                return;
+                return false;
             }
             registers[(int) instr->rd] = sum;
             break;
@@ -112,7 +300,7 @@ Machine::OneInstruction(Instruction *instr)
             if (!((registers[(int) instr->rs] ^ instr->extra) & SIGN_BIT)
                   && ((instr->extra ^ sum) & SIGN_BIT)) {
                 RaiseException(OVERFLOW_EXCEPTION, 0);
-                return;
+                return false;
             }
             registers[(int)instr->rt] = sum;
             break;
@@ -213,7 +401,7 @@ Machine::OneInstruction(Instruction *instr)
         case OP_LBU:
             tmp = registers[(int) instr->rs] + instr->extra;
             if (!machine->ReadMem(tmp, 1, &value))
-                return;
+                return false;
 
             if ((value & 0x80) && (instr->opCode == OP_LB))
                 value |= 0xFFFFFF00;
@@ -228,10 +416,10 @@ Machine::OneInstruction(Instruction *instr)
             tmp = registers[(int) instr->rs] + instr->extra;
             if (tmp & 0x1) {
                 RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
-                return;
+                return false;
             }
             if (!machine->ReadMem(tmp, 2, &value))
-                return;
+                return false;
 
             if ((value & 0x8000) && (instr->opCode == OP_LH))
                 value |= 0xFFFF0000;
@@ -250,10 +438,10 @@ Machine::OneInstruction(Instruction *instr)
             tmp = registers[(int) instr->rs] + instr->extra;
             if (tmp & 0x3) {
                 RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
-                return;
+                return false;
             }
             if (!machine->ReadMem(tmp, 4, &value))
-                return;
+                return false;
             nextLoadReg = instr->rt;
             nextLoadValue = value;
             break;
@@ -267,7 +455,7 @@ Machine::OneInstruction(Instruction *instr)
             ASSERT((tmp & 0x3) == 0);
 
             if (!machine->ReadMem(tmp, 4, &value))
-                return;
+                return false;
             if (registers[LOAD_REG] == instr->rt)
                 nextLoadValue = registers[LOAD_VALUE_REG];
             else
@@ -298,7 +486,7 @@ Machine::OneInstruction(Instruction *instr)
             ASSERT((tmp & 0x3) == 0);
 
             if (!machine->ReadMem(tmp, 4, &value))
-                return;
+                return false;
             if (registers[LOAD_REG] == instr->rt)
                 nextLoadValue = registers[LOAD_VALUE_REG];
             else
@@ -368,14 +556,14 @@ Machine::OneInstruction(Instruction *instr)
             if (!machine->WriteMem((unsigned) (registers[(int) instr->rs]
                                                + instr->extra),
                                    1, registers[(int)instr->rt]))
-                return;
+                return false;
             break;
 
         case OP_SH:
             if (!machine->WriteMem((unsigned) (registers[(int) instr->rs]
                                                + instr->extra),
                                    2, registers[(int) instr->rt]))
-                return;
+                return false;
             break;
 
         case OP_SLL:
@@ -450,7 +638,7 @@ Machine::OneInstruction(Instruction *instr)
                     & SIGN_BIT
                   && (registers[(int) instr->rs] ^ diff) & SIGN_BIT) {
                 RaiseException(OVERFLOW_EXCEPTION, 0);
-                return;
+                return false;
             }
             registers[(int) instr->rd] = diff;
             break;
@@ -464,7 +652,7 @@ Machine::OneInstruction(Instruction *instr)
             if (!machine->WriteMem((unsigned) (registers[(int) instr->rs]
                                                + instr->extra),
                                    4, registers[(int) instr->rt]))
-                return;
+                return false;
             break;
 
         case OP_SWL:
@@ -475,7 +663,7 @@ Machine::OneInstruction(Instruction *instr)
             ASSERT((tmp & 0x3) == 0);
 
             if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-                return;
+                return false;
             switch (tmp & 0x3) {
                 case 0:
                     value = registers[(int) instr->rt];
@@ -494,7 +682,7 @@ Machine::OneInstruction(Instruction *instr)
                     break;
             }
             if (!machine->WriteMem(tmp & ~0x3, 4, value))
-                return;
+                return false;
             break;
 
         case OP_SWR:
@@ -505,7 +693,7 @@ Machine::OneInstruction(Instruction *instr)
             ASSERT((tmp & 0x3) == 0);
 
             if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-                return;
+                return false;
             switch (tmp & 0x3) {
                 case 0:
                     value = (value & 0xFFFFFF)
@@ -523,12 +711,12 @@ Machine::OneInstruction(Instruction *instr)
                     break;
             }
             if (!machine->WriteMem(tmp & ~0x3, 4, value))
-                return;
+                return false;
             break;
 
         case OP_SYSCALL:
             RaiseException(SYSCALL_EXCEPTION, 0);
-            return;
+            return false;
 
         case OP_XOR:
             registers[(int) instr->rd] = registers[(int) instr->rs]
@@ -543,7 +731,7 @@ Machine::OneInstruction(Instruction *instr)
         case OP_RES:
         case OP_UNIMP:
             RaiseException(ILLEGAL_INSTR_EXCEPTION, 0);
-            return;
+            return false;
 
         default:
             ASSERT(false);
@@ -559,6 +747,7 @@ Machine::OneInstruction(Instruction *instr)
       // For debugging, in case we are jumping into lala-land.
     registers[PC_REG] = registers[NEXT_PC_REG];
     registers[NEXT_PC_REG] = pcAfter;
+    return true;
 }
 
 /// Simulate effects of a delayed load.
@@ -82,14 +82,13 @@ Network::CheckPktAvail()
         return;
 
     // Otherwise, read packet in.
-    char *buffer = new char[MAX_WIRE_SIZE];
+    char buffer[MAX_WIRE_SIZE];
     ReadFromSocket(sock, buffer, MAX_WIRE_SIZE);
 
     // Divide packet into header and data.
     inHdr = *(PacketHeader *) buffer;
     ASSERT(inHdr.to == ident && inHdr.length <= MAX_PACKET_SIZE);
     memcpy(inbox, buffer + sizeof (PacketHeader), inHdr.length);
-    delete [] buffer;
 
     DEBUG('n', "Network received packet from %d, length %u...\n",
           (int) inHdr.from, inHdr.length);
@@ -133,11 +132,10 @@ Network::Send(PacketHeader hdr, const char *data)
     }
 
     // Concatenate `hdr` and `data` into a single buffer, and send it out.
-    char *buffer = new char[MAX_WIRE_SIZE];
+    char buffer[MAX_WIRE_SIZE];
     *(PacketHeader *) buffer = hdr;
     memcpy(buffer + sizeof (PacketHeader), data, hdr.length);
     SendToSocket(sock, buffer, MAX_WIRE_SIZE, toName);
-    delete [] buffer;
 }
 
 // Read a packet, if one is buffered.
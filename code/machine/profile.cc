@@ -0,0 +1,187 @@
+/// Routines to profile user programs.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "profile.hh"
+#include "threads/utility.hh"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+Profile::Profile()
+{
+    counts     = NULL;
+    numCounts  = 0;
+    textStart  = 0;
+    memset(&outside, 0, sizeof outside);
+    symbols    = NULL;
+    numSymbols = 0;
+    maxSymbols = 0;
+}
+
+Profile::~Profile()
+{
+    for (unsigned i = 0; i < numSymbols; i++)
+        delete [] symbols[i].name;
+    delete [] symbols;
+    delete [] counts;
+}
+
+/// Grow the array of counts so that it also covers the words from `start`
+/// to `start + size`, keeping the counts made so far.
+void
+Profile::AddText(unsigned start, unsigned size)
+{
+    unsigned first = start / 4;
+    unsigned end   = divRoundUp(start + size, 4);
+
+    if (numCounts > 0) {
+        if (textStart / 4 < first)
+            first = textStart / 4;
+        if (textStart / 4 + numCounts > end)
+            end = textStart / 4 + numCounts;
+        if (first == textStart / 4 && end == textStart / 4 + numCounts)
+            return;
+    }
+
+    Counts *bigger = new Counts[end - first];
+    memset(bigger, 0, (end - first) * sizeof *bigger);
+    if (numCounts > 0)
+        memcpy(&bigger[textStart / 4 - first], counts,
+               numCounts * sizeof *counts);
+    delete [] counts;
+    counts    = bigger;
+    numCounts = end - first;
+    textStart = first * 4;
+}
+
+void
+Profile::AddSymbol(unsigned value, const char *name)
+{
+    if (numSymbols == maxSymbols) {
+        maxSymbols = maxSymbols == 0 ? 64 : 2 * maxSymbols;
+        Symbol *bigger = new Symbol[maxSymbols];
+        if (numSymbols > 0)
+            memcpy(bigger, symbols, numSymbols * sizeof *symbols);
+        delete [] symbols;
+        symbols = bigger;
+    }
+    symbols[numSymbols].value = value;
+    symbols[numSymbols].name  = new char[strlen(name) + 1];
+    strcpy(symbols[numSymbols].name, name);
+    numSymbols++;
+}
+
+/// Binary search for the last symbol at or before `pc`.
+const Profile::Symbol *
+Profile::Lookup(unsigned pc) const
+{
+    unsigned low = 0, high = numSymbols;
+
+    while (low < high) {
+        unsigned middle = (low + high) / 2;
+        if (symbols[middle].value <= pc)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low > 0 ? &symbols[low - 1] : NULL;
+}
+
+/// Order symbols by address, for `qsort`.
+int
+Profile::CompareSymbols(const void *a, const void *b)
+{
+    unsigned x = ((const Symbol *) a)->value, y = ((const Symbol *) b)->value;
+
+    return x < y ? -1 : x > y;
+}
+
+/// Print the report: totals, then the routines that executed anything, the
+/// busiest first, then the hottest instructions.
+void
+Profile::Print()
+{
+    qsort(symbols, numSymbols, sizeof *symbols, CompareSymbols);
+
+    // Add up by routine; the last entry is for text before every symbol.
+    Counts   total   = outside;
+    Counts  *byName  = new Counts[numSymbols + 1];
+    unsigned hot[PROFILE_HOT_INSTRUCTIONS];
+    unsigned numHot  = 0;
+
+    memset(byName, 0, (numSymbols + 1) * sizeof *byName);
+    for (unsigned i = 0; i < numCounts; i++) {
+        const Counts *c = &counts[i];
+        if (c->instructions == 0 && c->tlbMisses == 0 && c->pageFaults == 0)
+            continue;
+
+        const Symbol *sym = Lookup(textStart + 4 * i);
+        Counts *routine = &byName[sym != NULL ? sym - symbols : numSymbols];
+        routine->instructions += c->instructions;
+        routine->tlbMisses    += c->tlbMisses;
+        routine->pageFaults   += c->pageFaults;
+        total.instructions    += c->instructions;
+        total.tlbMisses       += c->tlbMisses;
+        total.pageFaults      += c->pageFaults;
+
+        // Keep the hottest instructions, sorted, by insertion.
+        unsigned j = numHot < PROFILE_HOT_INSTRUCTIONS ? numHot++ : numHot;
+        for (; j > 0 && counts[hot[j - 1]].instructions < c->instructions;
+             j--)
+            if (j < PROFILE_HOT_INSTRUCTIONS)
+                hot[j] = hot[j - 1];
+        if (j < PROFILE_HOT_INSTRUCTIONS)
+            hot[j] = i;
+    }
+
+    printf("\nProfile: instructions %llu (%llu outside the text), "
+           "TLB misses %u, page faults %u\n",
+           total.instructions, outside.instructions,
+           total.tlbMisses, total.pageFaults);
+
+    if (numSymbols > 0) {
+        printf("%14s %7s %11s %12s  %s\n", "instructions", "%",
+               "TLB misses", "page faults", "routine");
+        for (;;) {  // Selection, busiest first; there are few routines.
+            Counts  *busiest = NULL;
+            unsigned which   = 0;
+            for (unsigned i = 0; i <= numSymbols; i++) {
+                Counts *c = &byName[i];
+                if ((c->instructions > 0 || c->tlbMisses > 0
+                       || c->pageFaults > 0)
+                      && (busiest == NULL
+                          || c->instructions > busiest->instructions)) {
+                    busiest = c;
+                    which   = i;
+                }
+            }
+            if (busiest == NULL)
+                break;
+            printf("%14llu %7.2f %11u %12u  %s\n", busiest->instructions,
+                   total.instructions == 0 ? 0.0
+                     : 100.0 * busiest->instructions / total.instructions,
+                   busiest->tlbMisses, busiest->pageFaults,
+                   which < numSymbols ? symbols[which].name : "?");
+            memset(busiest, 0, sizeof *busiest);
+        }
+    }
+
+    if (numHot > 0)
+        printf("Hottest instructions:\n");
+    for (unsigned i = 0; i < numHot; i++) {
+        unsigned      pc  = textStart + 4 * hot[i];
+        const Symbol *sym = Lookup(pc);
+        if (sym != NULL)
+            printf("    0x%08X  %s+0x%X", pc, sym->name, pc - sym->value);
+        else
+            printf("    0x%08X", pc);
+        printf("  %llu\n", counts[hot[i]].instructions);
+    }
+
+    delete [] byName;
+}
@@ -0,0 +1,103 @@
+/// Data structures for profiling user programs.
+///
+/// When profiling is enabled (with the `-prof` flag), the simulator counts,
+/// for every instruction of the text segment, how many times it was
+/// executed, and how many TLB misses and page faults it caused.  Counts are
+/// kept in an array indexed by text address, so that counting costs no more
+/// than an increment.
+///
+/// At `Interrupt::Halt` the counts are reported by routine, and the hottest
+/// instructions are listed.  Routines are named after the symbols that
+/// `coff2noff` copies into the optional symbol section of NOFF files (see
+/// `bin/noff.h`); without them, only addresses are shown.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_PROFILE__HH
+#define NACHOS_MACHINE_PROFILE__HH
+
+
+/// Number of instructions listed in the report as the hottest ones.
+const unsigned PROFILE_HOT_INSTRUCTIONS = 10;
+
+class Profile {
+public:
+
+    /// Initialize a profile that covers no text yet.
+    Profile();
+
+    /// De-allocate the counts and symbols.
+    ~Profile();
+
+    /// Make the profile cover `size` bytes of text starting at `start`,
+    /// besides whatever it covered before.  Instructions outside of the
+    /// text are counted together.
+    void AddText(unsigned start, unsigned size);
+
+    /// Name the routine starting at address `value`.
+    void AddSymbol(unsigned value, const char *name);
+
+    /// Count an execution of the instruction at `pc`.
+    void CountInstruction(unsigned pc)
+    {
+        At(pc)->instructions++;
+    }
+
+    /// Count a TLB miss or a page fault caused by the instruction at `pc`.
+    void CountTlbMiss(unsigned pc)
+    {
+        At(pc)->tlbMisses++;
+    }
+
+    void CountPageFault(unsigned pc)
+    {
+        At(pc)->pageFaults++;
+    }
+
+    /// Print the report.
+    void Print();
+
+private:
+
+    struct Counts {
+        unsigned long long instructions;
+        unsigned tlbMisses;
+        unsigned pageFaults;
+    };
+
+    struct Symbol {
+        unsigned value;
+        char *name;
+    };
+
+    /// Counts of the instruction at `pc`.
+    Counts *At(unsigned pc)
+    {
+        unsigned i = (pc - textStart) / 4;
+        return i < numCounts ? &counts[i] : &outside;
+    }
+
+    /// Return the routine containing `pc`, or NULL if it comes before every
+    /// symbol.  Symbols must be sorted.
+    const Symbol *Lookup(unsigned pc) const;
+
+    static int CompareSymbols(const void *a, const void *b);
+
+    /// Counts of every word of text, starting at `textStart`.
+    Counts *counts;
+    unsigned numCounts;
+    unsigned textStart;
+
+    /// Counts of instructions outside of the text.
+    Counts outside;
+
+    Symbol *symbols;
+    unsigned numSymbols;
+    unsigned maxSymbols;
+
+};
+
+
+#endif
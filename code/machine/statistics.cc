@@ -19,10 +19,22 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
-#ifdef DFS_TICKS_FIX
-    tickResets = 0;
-#endif
+    for (unsigned i = 0; i < MAX_SCHEDULING_LEVELS; i++)
+        levelTicks[i] = 0;
+    numLevels = 0;
+    numVoluntarySwitches = numInvoluntarySwitches = 0;
+    for (unsigned i = 0; i < LATENCY_BUCKETS; i++)
+        readyLatency[i] = 0;
+}
+
+void
+Statistics::CountReadyLatency(unsigned long long ticks)
+{
+    unsigned bucket = 0;
 
+    for (; ticks > 0 && bucket < LATENCY_BUCKETS - 1; ticks >>= 1)
+        bucket++;
+    readyLatency[bucket]++;
 }
 
 /// Print performance metrics, when we have finished everything at system
@@ -30,12 +42,7 @@ Statistics::Statistics()
 void
 Statistics::Print()
 {
-#ifdef DFS_TICKS_FIX
-    if (tickResets != 0)
-        printf("WARNING: the tick counter was reset %lu times; the following"
-               " statistics may be invalid.\n\n", tickResets);
-#endif
-    printf("Ticks: total %u, idle %u, system %u, user %u\n",
+    printf("Ticks: total %llu, idle %llu, system %llu, user %llu\n",
            totalTicks, idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %u, writes %u\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %u, writes %u\n",
@@ -43,4 +50,33 @@ Statistics::Print()
     printf("Paging: faults %u\n", numPageFaults);
     printf("Network I/O: packets received %u, sent %u\n",
            numPacketsRecvd, numPacketsSent);
+
+    printf("Context switches: voluntary %llu, involuntary %llu\n",
+           numVoluntarySwitches, numInvoluntarySwitches);
+    bool anyLatency = false;
+    for (unsigned i = 0; i < LATENCY_BUCKETS; i++) {
+        if (readyLatency[i] == 0)
+            continue;
+        if (!anyLatency)
+            printf("Ready-to-run latency, in ticks:\n");
+        anyLatency = true;
+        unsigned long long low = i == 0 ? 0 : 1ULL << (i - 1);
+        if (i == LATENCY_BUCKETS - 1)
+            printf("    %6llu or more %10llu\n", low, readyLatency[i]);
+        else
+            printf("    %6llu to %6llu %10llu\n", low,
+                   i == 0 ? 0 : (1ULL << i) - 1, readyLatency[i]);
+    }
+
+    unsigned long long levelsTotal = 0;
+    for (unsigned i = 0; i < numLevels; i++)
+        levelsTotal += levelTicks[i];
+    if (levelsTotal > 0) {
+        printf("Scheduling levels:");
+        for (unsigned i = numLevels; i-- > 0; )
+            if (levelTicks[i] > 0)
+                printf(" %u: %llu (%.1f%%)", i, levelTicks[i],
+                       100.0 * levelTicks[i] / levelsTotal);
+        printf("\n");
+    }
 }
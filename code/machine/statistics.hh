@@ -11,6 +11,12 @@
 #define NACHOS_MACHINE_STATS__HH
 
 
+/// Largest number of scheduling levels whose residency can be kept.
+const unsigned MAX_SCHEDULING_LEVELS = 32;
+
+/// Number of buckets of the histogram of ready-to-run latencies.
+const unsigned LATENCY_BUCKETS = 16;
+
 /// The following class defines the statistics that are to be kept about
 /// Nachos behavior -- how much time (ticks) elapsed, how many user
 /// instructions executed, etc.
@@ -20,17 +26,19 @@ class Statistics {
 public:
 
     /// Total time running Nachos.
-    unsigned totalTicks;
+    ///
+    /// Times are kept in 64 bits, so that they never wrap around.
+    unsigned long long totalTicks;
 
     /// Time spent idle (no threads to run).
-    unsigned idleTicks;
+    unsigned long long idleTicks;
 
     /// Time spent executing system code.
-    unsigned systemTicks;
+    unsigned long long systemTicks;
 
     /// Time spent executing user code (this is also equal to # of user
     /// instructions executed).
-    unsigned userTicks;
+    unsigned long long userTicks;
 
     /// Number of disk read requests.
     unsigned numDiskReads;
@@ -53,10 +61,23 @@ public:
     /// Number of packets received over the network.
     unsigned numPacketsRecvd;
 
-#ifdef DFS_TICKS_FIX
-    /// Number of times the tick count gets reset.
-    unsigned long tickResets;
-#endif
+    /// Time spent running threads at each level of the multilevel feedback
+    /// queue, when that scheduling policy is in use (`numLevels > 0`).
+    unsigned long long levelTicks[MAX_SCHEDULING_LEVELS];
+    unsigned numLevels;
+
+    /// Context switches away from threads that blocked or finished
+    /// (voluntary), and away from threads still ready to run (involuntary).
+    unsigned long long numVoluntarySwitches;
+    unsigned long long numInvoluntarySwitches;
+
+    /// Histogram of the time threads waited on the ready list before they
+    /// ran: bucket 0 counts waits of no time, and bucket `i`, waits of
+    /// `2^(i-1)` to `2^i - 1` ticks; the last one counts longer ones too.
+    unsigned long long readyLatency[LATENCY_BUCKETS];
+
+    /// Count a wait of `ticks` on the ready list.
+    void CountReadyLatency(unsigned long long ticks);
 
     /// Initialize everything to zero.
     Statistics();
@@ -380,3 +380,25 @@ DeallocBoundedArray(const char *ptr, int size)
 #endif
     delete [] (ptr - pgSize);
 }
+
+/// Return an array that can hold host machine code generated at run time,
+/// or NULL if the host does not allow it.
+///
+/// * `size` -- amount of space needed (in bytes).
+char *
+AllocExecutableArray(int size)
+{
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : (char *) ptr;
+}
+
+/// Deallocate an array returned by `AllocExecutableArray`.
+///
+/// * `ptr` is the array to be deallocated.
+/// * `size` is the size of the array (in bytes).
+void
+DeallocExecutableArray(char *ptr, int size)
+{
+    munmap(ptr, size);
+}
@@ -82,6 +82,13 @@ extern char *AllocBoundedArray(int size);
 
 extern void DeallocBoundedArray(const char *p, int size);
 
+/// Allocate, de-allocate an array whose contents can be executed as host
+/// machine code.
+
+extern char *AllocExecutableArray(int size);
+
+extern void DeallocExecutableArray(char *p, int size);
+
 /// Other C library routines that are used by Nachos.
 /// These are assumed to be portable, so we do not include a wrapper.
 extern "C" {
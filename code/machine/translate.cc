@@ -29,6 +29,7 @@
 
 
 #include "machine.hh"
+#include "profile.hh"
 #include "threads/system.hh"
 #include "userprog/address_space.hh"
 
@@ -93,13 +94,17 @@ Machine::ReadMem(unsigned addr, unsigned size, int *value)
     int           data;
     ExceptionType exception;
     unsigned      physicalAddress;
+    bool          cached = CachedTranslate(addr, &physicalAddress,
+                                           size, false);
 
-    DEBUG('a', "Reading VA 0x%X, size %u\n", addr, size);
+    if (!cached) {
+        DEBUG('a', "Reading VA 0x%X, size %u\n", addr, size);
 
-    exception = Translate(addr, &physicalAddress, size, false);
-    if (exception != NO_EXCEPTION) {
-        machine->RaiseException(exception, addr);
-        return false;
+        exception = Translate(addr, &physicalAddress, size, false);
+        if (exception != NO_EXCEPTION) {
+            machine->RaiseException(exception, addr);
+            return false;
+        }
     }
     switch (size) {
         case 1:
@@ -120,7 +125,8 @@ Machine::ReadMem(unsigned addr, unsigned size, int *value)
         default: ASSERT(false);
     }
 
-    DEBUG('a', "\tvalue read = %8.8x\n", *value);
+    if (!cached)
+        DEBUG('a', "\tvalue read = %8.8x\n", *value);
     return true;
 }
 
@@ -139,12 +145,15 @@ Machine::WriteMem(unsigned addr, unsigned size, int value)
     ExceptionType exception;
     unsigned      physicalAddress;
 
-    DEBUG('a', "Writing VA 0x%X, size %u, value 0x%X\n", addr, size, value);
+    if (!CachedTranslate(addr, &physicalAddress, size, true)) {
+        DEBUG('a', "Writing VA 0x%X, size %u, value 0x%X\n",
+              addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, true);
-    if (exception != NO_EXCEPTION) {
-        machine->RaiseException(exception, addr);
-        return false;
+        exception = Translate(addr, &physicalAddress, size, true);
+        if (exception != NO_EXCEPTION) {
+            machine->RaiseException(exception, addr);
+            return false;
+        }
     }
     switch (size) {
         case 1:
@@ -165,10 +174,133 @@ Machine::WriteMem(unsigned addr, unsigned size, int value)
         default:
             ASSERT(false);
     }
+    if (decodeCache->Written(physicalAddress))
+        blockCache->InvalidateFrame(physicalAddress / PAGE_SIZE);
+
+    return true;
+}
+
+/// Copy `size` bytes of user virtual memory, starting at `virtAddr`, into
+/// `buffer`.
+///
+/// Each page is translated once, and the part of it that is needed is
+/// copied at once, instead of going through `ReadMem` for every byte.
+///
+/// Returns false if the translation of some page failed; the bytes before
+/// it have been copied already.
+///
+/// * `virtAddr` is the virtual address to read from.
+/// * `buffer` is the kernel buffer to copy into.
+/// * `size` is the number of bytes to copy.
+bool
+Machine::CopyFromUser(unsigned virtAddr, char *buffer, unsigned size)
+{
+    while (size > 0) {
+        unsigned physAddr;
+        if (!TranslateForCopy(virtAddr, &physAddr, false))
+            return false;
+
+        unsigned span = PAGE_SIZE - virtAddr % PAGE_SIZE;
+        if (span > size)
+            span = size;
+        memcpy(buffer, &mainMemory[physAddr], span);
+        virtAddr += span;
+        buffer   += span;
+        size     -= span;
+    }
+    return true;
+}
+
+/// Copy `size` bytes from `buffer` into user virtual memory, starting at
+/// `virtAddr`, a page at a time.
+///
+/// Anything the simulator cached about the pages written is discarded, as
+/// `WriteMem` does.
+///
+/// Returns false if the translation of some page failed; the bytes before
+/// it have been copied already.
+///
+/// * `virtAddr` is the virtual address to write to.
+/// * `buffer` is the kernel buffer to copy from.
+/// * `size` is the number of bytes to copy.
+bool
+Machine::CopyToUser(unsigned virtAddr, const char *buffer, unsigned size)
+{
+    while (size > 0) {
+        unsigned physAddr;
+        if (!TranslateForCopy(virtAddr, &physAddr, true))
+            return false;
 
+        unsigned span = PAGE_SIZE - virtAddr % PAGE_SIZE;
+        if (span > size)
+            span = size;
+        memcpy(&mainMemory[physAddr], buffer, span);
+        if (decodeCache->Written(physAddr))
+            blockCache->InvalidateFrame(physAddr / PAGE_SIZE);
+        virtAddr += span;
+        buffer   += span;
+        size     -= span;
+    }
     return true;
 }
 
+/// Copy a null-terminated string of user virtual memory, starting at
+/// `virtAddr`, into `buffer`, a page at a time.
+///
+/// At most `maxSize` bytes are copied, including the null character; if
+/// none is found among them, `buffer` is left unterminated.
+///
+/// Returns false if the translation of some page failed before the end of
+/// the string.
+bool
+Machine::CopyStringFromUser(unsigned virtAddr, char *buffer, unsigned maxSize)
+{
+    while (maxSize > 0) {
+        unsigned physAddr;
+        if (!TranslateForCopy(virtAddr, &physAddr, false))
+            return false;
+
+        unsigned span = PAGE_SIZE - virtAddr % PAGE_SIZE;
+        if (span > maxSize)
+            span = maxSize;
+
+        const char *end = (const char *) memchr(&mainMemory[physAddr],
+                                                '\0', span);
+        if (end != NULL)
+            span = end - &mainMemory[physAddr] + 1;
+        memcpy(buffer, &mainMemory[physAddr], span);
+        if (end != NULL)
+            break;
+        virtAddr += span;
+        buffer   += span;
+        maxSize  -= span;
+    }
+    return true;
+}
+
+/// Translate `virtAddr` for a copy done by the kernel.
+///
+/// If the page is not in the page table or TLB, the kernel is given a
+/// chance to bring it in, as if the user program had touched it, and the
+/// translation is retried once.  Any other failure is returned right away,
+/// since the copy cannot go on.
+bool
+Machine::TranslateForCopy(unsigned virtAddr, unsigned *physAddr,
+                          bool writing)
+{
+    if (CachedTranslate(virtAddr, physAddr, 1, writing))
+        return true;
+
+    ExceptionType exception = Translate(virtAddr, physAddr, 1, writing);
+    if (exception == PAGE_FAULT_EXCEPTION) {
+        registers[BAD_VADDR_REG] = virtAddr;
+        FlushTranslationCache();
+        ExceptionHandler(exception);
+        exception = Translate(virtAddr, physAddr, 1, writing);
+    }
+    return exception == NO_EXCEPTION;
+}
+
 /// Translate a virtual address into a physical address, using
 /// either a page table or a TLB.
 ///
@@ -216,11 +348,13 @@ Machine::Translate(unsigned virtAddr, unsigned *physAddr,
             DEBUG('a',
                   "virtual page # %u too large for page table size %u!\n",
                   virtAddr, pageTableSize);
+            if (profile != NULL)
+                profile->CountPageFault(registers[PC_REG]);
             return PAGE_FAULT_EXCEPTION;
         }
         entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLB_SIZE; i++)
+        for (entry = NULL, i = 0; i < tlbSize; i++)
             if (tlb[i].valid && tlb[i].virtualPage == vpn) {
                 entry = &tlb[i];  // FOUND!
                 break;
@@ -228,6 +362,8 @@ Machine::Translate(unsigned virtAddr, unsigned *physAddr,
         if (entry == NULL) {  // Not found.
             DEBUG('a',
                   "*** no valid TLB entry found for this virtual page!\n");
+            if (profile != NULL)
+                profile->CountTlbMiss(registers[PC_REG]);
             return PAGE_FAULT_EXCEPTION;  // Really, this is a TLB fault, the
                                           // page may be in memory, but not
                                           // in the TLB.
@@ -243,15 +379,56 @@ Machine::Translate(unsigned virtAddr, unsigned *physAddr,
 
     // If the `pageFrame` is too big, there is something really wrong!  An
     // invalid translation was loaded into the page table or TLB.
-    if (pageFrame >= NUM_PHYS_PAGES) {
-        DEBUG('a', "*** frame %u > %u!\n", pageFrame, NUM_PHYS_PAGES);
+    if (pageFrame >= numPhysPages) {
+        DEBUG('a', "*** frame %u > %u!\n", pageFrame, numPhysPages);
         return BUS_ERROR_EXCEPTION;
     }
     entry->use = true;  // Set the `use`, `dirty` bits.
     if (writing)
         entry->dirty = true;
     *physAddr = pageFrame * PAGE_SIZE + offset;
-    ASSERT(*physAddr >= 0 && *physAddr + size <= MEMORY_SIZE);
+    ASSERT(*physAddr >= 0 && *physAddr + size <= memorySize);
     DEBUG('a', "phys addr = 0x%X\n", *physAddr);
+
+    if (cacheTranslations) {
+        CachedTranslation *cached
+          = &translationCache[vpn % TRANSLATION_CACHE_SIZE];
+        cached->vpn      = vpn;
+        cached->host     = &mainMemory[pageFrame * PAGE_SIZE];
+        cached->entry    = entry;
+        cached->readable = true;
+        cached->writable = !entry->readOnly;
+    }
     return NO_EXCEPTION;
 }
+
+/// Translate a virtual address into a physical address, if the translation
+/// of its page has been cached since the last `FlushTranslationCache`.
+///
+/// On a hit, the access is known to be legal, so the use and dirty bits are
+/// set as `Translate` would, and the physical address is stored in
+/// `physAddr`.  On a miss (including unaligned accesses) return false and
+/// leave everything alone; `Translate` has to be called then.
+///
+/// * `virtAddr` is the virtual address to translate.
+/// * `physAddr` is the place to store the physical address.
+/// * `size` is the amount of memory being read or written.
+/// * `writing` -- if true, the page must be writable.
+bool
+Machine::CachedTranslate(unsigned virtAddr, unsigned *physAddr,
+                         unsigned size, bool writing)
+{
+    unsigned           vpn    = virtAddr / PAGE_SIZE;
+    CachedTranslation *cached
+      = &translationCache[vpn % TRANSLATION_CACHE_SIZE];
+
+    if (cached->vpn != vpn || (virtAddr & (size - 1)) != 0
+          || !(writing ? cached->writable : cached->readable))
+        return false;
+
+    cached->entry->use = true;
+    if (writing)
+        cached->entry->dirty = true;
+    *physAddr = cached->host - mainMemory + virtAddr % PAGE_SIZE;
+    return true;
+}
@@ -21,6 +21,9 @@
 #include "post.hh"
 
 
+SlabAllocator Mail::slab;
+
+
 /// Initialize a single mail message, by concatenating the headers to
 /// the data.
 ///
@@ -196,7 +199,7 @@ PostOffice::PostalDelivery()
 {
     PacketHeader pktHdr;
     MailHeader   mailHdr;
-    char        *buffer = new char[MAX_PACKET_SIZE];
+    char         buffer[MAX_PACKET_SIZE];
 
     for (;;) {
         // First, wait for a message.
@@ -230,8 +233,8 @@ PostOffice::PostalDelivery()
 void
 PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, const char *data)
 {
-    char *buffer = new char[MAX_PACKET_SIZE];  // Space to hold concatenated
-                                               // `mailHdr` + data.
+    char buffer[MAX_PACKET_SIZE];  // Space to hold concatenated `mailHdr` +
+                                   // data.
 
     if (DebugIsEnabled('n')) {
         printf("Post send: ");
@@ -254,9 +257,6 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, const char *data)
     messageSent->P();  // Wait for interrupt to tell us ok to send the next
                        // message.
     sendLock->Release();
-
-    delete [] buffer;  // We have sent the message, so we can delete our
-                       // buffer.
 }
 
 /// Retrieve a message from a specific box if one is available, otherwise
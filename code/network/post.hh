@@ -28,6 +28,7 @@
 
 
 #include "network.hh"
+#include "threads/slab.hh"
 #include "threads/synch_list.hh"
 
 
@@ -65,9 +66,19 @@ public:
     /// Initialize a mail message by concatenating the headers to the data.
     Mail(PacketHeader pktH, MailHeader mailH, const char *msgData);
 
+    /// Mail is taken from a slab, since every message that arrives is put
+    /// in one until it is read.
+    void *operator new(size_t size)
+    { return slab.Allocate("mail", size); }
+    void operator delete(void *mail)
+    { slab.Free(mail); }
+
     PacketHeader pktHdr;               ///< Header appended by `Network`.
     MailHeader   mailHdr;              ///< Header appended by `PostOffice`.
     char         data[MAX_MAIL_SIZE];  ///< Payload -- message data.
+
+private:
+    static SlabAllocator slab;
 };
 
 /// The following class defines a single mailbox, or temporary storage
@@ -123,6 +123,22 @@ Yield:
         j       $31
         .end    Yield
 
+        .globl  Sleep
+        .ent    Sleep
+Sleep:
+        addiu   $2, $0, SC_Sleep
+        syscall
+        j       $31
+        .end    Sleep
+
+        .globl  Stats
+        .ent    Stats
+Stats:
+        addiu   $2, $0, SC_Stats
+        syscall
+        j       $31
+        .end    Stats
+
 /// Dummy function to keep gcc happy.
         .globl  __main
         .ent    __main
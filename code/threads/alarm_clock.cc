@@ -0,0 +1,76 @@
+/// Routines to put threads to sleep for a while.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "alarm_clock.hh"
+#include "system.hh"
+
+
+AlarmClock::AlarmClock()
+{
+    armedFor = 0;
+}
+
+AlarmClock::~AlarmClock()
+{}
+
+/// The thread is put in order among the sleepers, after those that wake up
+/// at the same time, so that they wake up in the order they went to sleep.
+void
+AlarmClock::SleepFor(unsigned ticks)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (ticks == 0)
+        ticks = 1;
+    currentThread->wakeTime = stats->totalTicks + ticks;
+
+    Thread *next = sleepers.Peek();
+    while (next != NULL && next->wakeTime <= currentThread->wakeTime)
+        next = sleepers.Next(next);
+    sleepers.InsertBefore(currentThread, next);
+
+    Arm();
+    currentThread->Sleep();
+    interrupt->SetLevel(oldLevel);
+}
+
+/// Called with interrupts disabled.  The woken threads preempt the current
+/// one if any of them has a higher priority.
+void
+AlarmClock::Ring(void *arg)
+{
+    AlarmClock *clock = (AlarmClock *) arg;
+    Thread     *thread;
+    int         woken = -1;
+
+    if (clock->armedFor <= stats->totalTicks)
+        clock->armedFor = 0;
+
+    while ((thread = clock->sleepers.Peek()) != NULL
+             && thread->wakeTime <= stats->totalTicks) {
+        clock->sleepers.Remove();
+        DEBUG('t', "Waking up thread \"%s\"\n", thread->getName());
+        scheduler->ReadyToRun(thread);
+        if (thread->GetPriority() > woken)
+            woken = thread->GetPriority();
+    }
+    if (woken > currentThread->GetPriority())
+        interrupt->YieldOnReturn();
+
+    clock->Arm();
+}
+
+void
+AlarmClock::Arm()
+{
+    Thread *first = sleepers.Peek();
+
+    if (first == NULL || (armedFor != 0 && armedFor <= first->wakeTime))
+        return;
+    armedFor = first->wakeTime;
+    interrupt->Schedule(Ring, this, armedFor - stats->totalTicks, ALARM_INT);
+}
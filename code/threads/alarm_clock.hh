@@ -0,0 +1,56 @@
+/// Data structures for putting threads to sleep for a while.
+///
+/// Sleeping threads are kept in order of wake-up time, and a single
+/// interrupt is scheduled for the earliest of them.  When it goes off, every
+/// thread that is due is woken up at once, and the interrupt is scheduled
+/// again for the next one.  Since nothing else is pending meanwhile,
+/// `Interrupt::Idle` can move the clock straight to that time when no thread
+/// is ready, instead of threads yielding until their time comes.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_ALARMCLOCK__HH
+#define NACHOS_THREADS_ALARMCLOCK__HH
+
+
+#include "thread.hh"
+
+
+/// The following class defines an alarm clock, on which any number of
+/// threads can sleep.
+class AlarmClock {
+public:
+
+    /// Initialize an alarm clock with no sleepers.
+    AlarmClock();
+
+    /// De-allocate an alarm clock.  Sleepers, if any, are never woken up.
+    ~AlarmClock();
+
+    /// Put the current thread to sleep for at least `ticks` ticks.
+    void SleepFor(unsigned ticks);
+
+private:
+
+    /// Interrupt handler: wake up every sleeper that is due.
+    static void Ring(void *arg);
+
+    /// Schedule an interrupt for the first sleeper, unless one is scheduled
+    /// for that time or earlier already.
+    void Arm();
+
+    /// Sleeping threads, by `Thread::wakeTime`, earliest first.  A sleeping
+    /// thread is on no other queue, so its `queueLink` is free.
+    IntrusiveList<Thread, &Thread::queueLink> sleepers;
+
+    /// Time of the earliest interrupt scheduled, 0 if none.  Interrupts
+    /// cannot be called off, so later ones may still be pending; they only
+    /// wake up whoever is due by then.
+    unsigned long long armedFor;
+
+};
+
+
+#endif
@@ -0,0 +1,67 @@
+/// Test of putting threads to sleep for a while.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef ALARM_TEST
+
+#include "thread_test.hh"
+#include "system.hh"
+
+
+/// How long each sleeper sleeps; some of them wake up at the same time.
+static const unsigned SLEEP_TICKS[] = { 5000, 300, 2000, 300, 1000, 300 };
+static const unsigned NUM_SLEEPERS = sizeof SLEEP_TICKS / sizeof *SLEEP_TICKS;
+
+static unsigned long long wokeAt[NUM_SLEEPERS];
+static unsigned wakeOrder[NUM_SLEEPERS], numWoken;
+
+static void
+Sleeper(void *which_)
+{
+    unsigned which = (unsigned) (long) which_;
+    unsigned long long start = stats->totalTicks;
+
+    currentThread->SleepFor(SLEEP_TICKS[which]);
+    wokeAt[which] = stats->totalTicks;
+    wakeOrder[numWoken++] = which;
+    ASSERT(wokeAt[which] >= start + SLEEP_TICKS[which]);
+}
+
+/// Check that sleepers wake up in order and on time, and that the time
+/// nobody can run is skipped rather than spent yielding.
+void
+AlarmTest()
+{
+    Thread *sleepers[NUM_SLEEPERS];
+    unsigned long long startTicks = stats->totalTicks;
+    unsigned long long startIdle  = stats->idleTicks;
+
+    numWoken = 0;
+    for (unsigned i = 0; i < NUM_SLEEPERS; i++) {
+        sleepers[i] = new Thread("sleeper", true, 9);
+        sleepers[i]->Fork(Sleeper, (void *) (long) i);
+    }
+    for (unsigned i = 0; i < NUM_SLEEPERS; i++)
+        sleepers[i]->Join();
+
+    printf("Sleepers woke up at:");
+    for (unsigned i = 0; i < NUM_SLEEPERS; i++) {
+        unsigned which = wakeOrder[i];
+        printf(" %llu", wokeAt[which] - startTicks);
+        if (i > 0) {
+            unsigned before = wakeOrder[i - 1];
+            ASSERT(SLEEP_TICKS[before] < SLEEP_TICKS[which]
+                   || (SLEEP_TICKS[before] == SLEEP_TICKS[which]
+                       && before < which));
+        }
+    }
+    printf("\nTicks: %llu, idle %llu\n", stats->totalTicks - startTicks,
+           stats->idleTicks - startIdle);
+    ASSERT(stats->idleTicks - startIdle
+           > (stats->totalTicks - startTicks) / 2);
+}
+
+#endif
@@ -0,0 +1,160 @@
+/// Data structures for bounded, buffered channels between threads.
+///
+/// Unlike a `Port`, where every `Send` waits for a `Receive`, a channel
+/// keeps up to a fixed number of items in a ring buffer, so that senders
+/// only wait when it is full and receivers only when it is empty.  Items can
+/// also be sent and received in batches, taking the lock once for many of
+/// them.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_CHANNEL__HH
+#define NACHOS_THREADS_CHANNEL__HH
+
+
+#include "synch.hh"
+
+
+/// The following class defines a channel of items of type `Item`, which
+/// are copied in and out by value.
+template <class Item>
+class Channel {
+public:
+
+    /// Initialize an empty channel with room for `capacity` items.
+    Channel(const char *debugName, unsigned capacity);
+
+    /// De-allocate a channel.  Items still in it are lost.
+    ~Channel();
+
+    const char *GetName()
+    {
+        return name;
+    }
+
+    /// Put `item` in the channel, waiting while it is full.
+    void Send(Item item);
+
+    /// Take the oldest item out of the channel into `item`, waiting while
+    /// it is empty.
+    void Receive(Item *item);
+
+    /// Put the `count` items of `items` in the channel, in order, waiting
+    /// whenever it is full.
+    void SendMany(const Item *items, unsigned count);
+
+    /// Take up to `max` items out of the channel into `items`, waiting
+    /// only while it is empty.  Returns how many were taken, at least one.
+    unsigned ReceiveMany(Item *items, unsigned max);
+
+private:
+
+    const char *name;
+
+    /// Ring buffer: `count` items starting at `first`, wrapping around at
+    /// `capacity`.
+    Item    *buffer;
+    unsigned capacity;
+    unsigned first;
+    unsigned count;
+
+    Lock      *lock;
+    Condition *notFull;
+    Condition *notEmpty;
+
+};
+
+template <class Item>
+Channel<Item>::Channel(const char *debugName, unsigned size)
+{
+    ASSERT(size > 0);
+    name     = debugName;
+    buffer   = new Item[size];
+    capacity = size;
+    first    = 0;
+    count    = 0;
+    lock     = new Lock(debugName);
+    notFull  = new Condition(debugName, lock);
+    notEmpty = new Condition(debugName, lock);
+}
+
+template <class Item>
+Channel<Item>::~Channel()
+{
+    delete notEmpty;
+    delete notFull;
+    delete lock;
+    delete [] buffer;
+}
+
+template <class Item>
+void
+Channel<Item>::Send(Item item)
+{
+    lock->Acquire();
+    while (count == capacity)
+        notFull->Wait();
+    buffer[(first + count) % capacity] = item;
+    count++;
+    notEmpty->Signal();
+    lock->Release();
+}
+
+template <class Item>
+void
+Channel<Item>::Receive(Item *item)
+{
+    lock->Acquire();
+    while (count == 0)
+        notEmpty->Wait();
+    *item = buffer[first];
+    first = (first + 1) % capacity;
+    count--;
+    notFull->Signal();
+    lock->Release();
+}
+
+/// Whenever the channel fills up, every receiver is woken up, since the
+/// items sent may be enough for more than one.
+template <class Item>
+void
+Channel<Item>::SendMany(const Item *items, unsigned total)
+{
+    unsigned sent = 0;
+
+    lock->Acquire();
+    while (sent < total) {
+        while (count == capacity)
+            notFull->Wait();
+        for (; sent < total && count < capacity; sent++, count++)
+            buffer[(first + count) % capacity] = items[sent];
+        notEmpty->Broadcast();
+    }
+    lock->Release();
+}
+
+/// Likewise, every sender is woken up, since the room made may be enough
+/// for more than one.
+template <class Item>
+unsigned
+Channel<Item>::ReceiveMany(Item *items, unsigned max)
+{
+    unsigned received = 0;
+
+    ASSERT(max > 0);
+    lock->Acquire();
+    while (count == 0)
+        notEmpty->Wait();
+    for (; received < max && count > 0; received++, count--) {
+        items[received] = buffer[first];
+        first = (first + 1) % capacity;
+    }
+    notFull->Broadcast();
+    lock->Release();
+    return received;
+}
+
+
+#endif
@@ -0,0 +1,99 @@
+/// Benchmark of passing values through ports and channels.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef CHANNEL_BENCH
+
+#include "thread_test.hh"
+#include "channel.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Number of values passed, capacity of the channel, and size of batches.
+static const unsigned CHANNEL_VALUES   = 1000000;
+static const unsigned CHANNEL_CAPACITY = 64;
+static const unsigned CHANNEL_BATCH    = 16;
+
+static Port         *benchPort;
+static Channel<int> *benchChannel;
+
+static void
+PortConsumer(void *arg)
+{
+    int value;
+
+    for (unsigned i = 0; i < CHANNEL_VALUES; i++) {
+        benchPort->Receive(&value);
+        ASSERT(value == (int) i);
+    }
+}
+
+static void
+ChannelConsumer(void *arg)
+{
+    int value;
+
+    for (unsigned i = 0; i < CHANNEL_VALUES; i++) {
+        benchChannel->Receive(&value);
+        ASSERT(value == (int) i);
+    }
+}
+
+static void
+BatchConsumer(void *arg)
+{
+    int values[CHANNEL_BATCH];
+
+    for (unsigned i = 0; i < CHANNEL_VALUES;) {
+        unsigned n = benchChannel->ReceiveMany(values, CHANNEL_BATCH);
+        for (unsigned j = 0; j < n; j++, i++)
+            ASSERT(values[j] == (int) i);
+    }
+}
+
+/// Pass values from this thread to a consumer through a `Port`, through a
+/// `Channel` one at a time, and through a `Channel` in batches.
+void
+ChannelBench()
+{
+    BenchClock         clock;
+    Thread            *consumer;
+
+    benchPort = new Port("bench");
+    consumer  = new Thread("consumer", true, currentThread->GetPriority());
+    clock.Restart();
+    consumer->Fork(PortConsumer, NULL);
+    for (unsigned i = 0; i < CHANNEL_VALUES; i++)
+        benchPort->Send(i);
+    consumer->Join();
+    clock.Report("Port", CHANNEL_VALUES, "values");
+    delete benchPort;
+
+    benchChannel = new Channel<int>("bench", CHANNEL_CAPACITY);
+    consumer = new Thread("consumer", true, currentThread->GetPriority());
+    clock.Restart();
+    consumer->Fork(ChannelConsumer, NULL);
+    for (unsigned i = 0; i < CHANNEL_VALUES; i++)
+        benchChannel->Send(i);
+    consumer->Join();
+    clock.Report("Channel", CHANNEL_VALUES, "values");
+
+    int values[CHANNEL_BATCH];
+    consumer = new Thread("consumer", true, currentThread->GetPriority());
+    clock.Restart();
+    consumer->Fork(BatchConsumer, NULL);
+    for (unsigned i = 0; i < CHANNEL_VALUES; i += CHANNEL_BATCH) {
+        for (unsigned j = 0; j < CHANNEL_BATCH; j++)
+            values[j] = i + j;
+        benchChannel->SendMany(values, CHANNEL_BATCH);
+    }
+    consumer->Join();
+    clock.Report("Channel in batches", CHANNEL_VALUES, "values");
+    delete benchChannel;
+}
+
+#endif
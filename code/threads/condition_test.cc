@@ -0,0 +1,81 @@
+/// Test of condition variables with a timeout, and benchmark of
+/// synchronized lists.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef CONDITION_TEST
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "synch_list.hh"
+#include "system.hh"
+
+
+/// Number of round trips through a pair of synchronized lists.
+static const unsigned LIST_ROUNDS = 200000;
+
+static Lock           *condLock;
+static Condition      *cond;
+static SynchList<int> *requests, *replies;
+
+/// Signal the condition after `ticks` of busy work.
+static void
+LateSignaler(void *ticks_)
+{
+    unsigned ticks = (unsigned) (long) ticks_;
+    unsigned long long until = stats->totalTicks + ticks;
+
+    while (stats->totalTicks < until)
+        currentThread->Yield();
+    condLock->Acquire();
+    cond->Signal();
+    condLock->Release();
+}
+
+static void
+Echo(void *arg)
+{
+    for (unsigned i = 0; i < LIST_ROUNDS; i++)
+        replies->Append(requests->Remove());
+}
+
+/// Check that `WaitFor` times out, and that it does not if signaled in
+/// time; then measure round trips through synchronized lists, which wait
+/// on condition variables.
+void
+ConditionTest()
+{
+    condLock = new Lock("condLock");
+    cond     = new Condition("cond", condLock);
+
+    condLock->Acquire();
+    unsigned long long before = stats->totalTicks;
+    bool signaled = cond->WaitFor(1000);
+    printf("Nobody signals: WaitFor returned %s after %llu ticks\n",
+           signaled ? "true" : "false", stats->totalTicks - before);
+
+    Thread *t = new Thread("signaler", true, 9);
+    t->Fork(LateSignaler, (void *) 300);
+    before   = stats->totalTicks;
+    signaled = cond->WaitFor(1000);
+    printf("Signaled in time: WaitFor returned %s after %llu ticks\n",
+           signaled ? "true" : "false", stats->totalTicks - before);
+    condLock->Release();
+    t->Join();
+
+    requests = new SynchList<int>;
+    replies  = new SynchList<int>;
+    (new Thread("echo", false, 9))->Fork(Echo, NULL);
+
+    BenchClock clock;
+    for (unsigned i = 0; i < LIST_ROUNDS; i++) {
+        requests->Append(i);
+        ASSERT(replies->Remove() == (int) i);
+    }
+    clock.Report("Synchronized lists", LIST_ROUNDS, "round trips");
+}
+
+#endif
@@ -0,0 +1,43 @@
+/// Benchmark of creating, running and destroying threads.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef FORK_BENCH
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Number of threads created and waited for, and how many at a time.
+static const unsigned BENCH_FORKS = 200000;
+static const unsigned BENCH_BATCH = 16;
+
+static Semaphore *forkDone;
+
+static void
+ForkedThread(void *arg)
+{
+    forkDone->V();
+}
+
+/// Measure how many threads per second can be created, run and destroyed,
+/// in batches, as one thread per user process would be.
+void
+ForkBench()
+{
+    forkDone = new Semaphore("forkDone", 0);
+    BenchClock clock;
+    for (unsigned i = 0; i < BENCH_FORKS; i += BENCH_BATCH) {
+        for (unsigned j = 0; j < BENCH_BATCH; j++)
+            (new Thread("forked", false, 9))->Fork(ForkedThread, NULL);
+        for (unsigned j = 0; j < BENCH_BATCH; j++)
+            forkDone->P();
+    }
+    clock.Report("Fork", BENCH_FORKS, "threads run and finished");
+}
+
+#endif
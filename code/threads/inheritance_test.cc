@@ -0,0 +1,124 @@
+/// Test of priority inheritance through chains of locks.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef INHERITANCE_TEST
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Number of yields each CPU-bound thread of medium priority does.
+static const unsigned HOG_ROUNDS = 1000;
+
+static Lock *lockA, *lockB, *lockC;
+static Semaphore *midGo, *waiterGo, *highGo, *hogGo, *lowGo;
+static unsigned hogYields;
+
+/// Holds `lockA`, which `Mid` waits for, and `lockC`, which `Waiter` waits
+/// for.  Its priority is 1, but it must run before the hogs, with the
+/// priority of the highest thread waiting behind it.
+static void
+Low(void *arg)
+{
+    lockA->Acquire();
+    lockC->Acquire();
+    Say("holds A and C");
+    midGo->V();
+    lowGo->P();
+    Say("releases A");
+    lockA->Release();
+    Say("released A, still holds C");
+    ASSERT(currentThread->GetPriority() == 6);
+    lockC->Release();
+    Say("released C");
+    ASSERT(currentThread->GetPriority() == 1);
+}
+
+/// Holds `lockB`, which `High` waits for, while waiting for `lockA`.
+static void
+Mid(void *arg)
+{
+    midGo->P();
+    lockB->Acquire();
+    Say("holds B, waits for A");
+    waiterGo->V();
+    lockA->Acquire();
+    Say("holds B and A");
+    lockA->Release();
+    lockB->Release();
+    Say("released B and A");
+    ASSERT(currentThread->GetPriority() == 3);
+}
+
+static void
+Waiter(void *arg)
+{
+    waiterGo->P();
+    highGo->V();
+    Say("waits for C");
+    lockC->Acquire();
+    Say("holds C");
+    lockC->Release();
+}
+
+static void
+High(void *arg)
+{
+    highGo->P();
+    hogGo->V();
+    hogGo->V();
+    lowGo->V();
+
+    unsigned long long start = stats->totalTicks;
+    Say("waits for B");
+    lockB->Acquire();
+    Say("holds B");
+    printf("High waited %llu ticks behind a chain of two locks, while the "
+           "hogs yielded %u of %u times\n", stats->totalTicks - start,
+           hogYields, 2 * HOG_ROUNDS);
+    ASSERT(hogYields == 0);
+    lockB->Release();
+}
+
+static void
+Hog(void *arg)
+{
+    hogGo->P();
+    Say("starts");
+    for (unsigned i = 0; i < HOG_ROUNDS; i++) {
+        hogYields++;
+        currentThread->Yield();
+    }
+    Say("finishes");
+}
+
+/// Start the threads of the priority inheritance test, which then set
+/// themselves up in order through the semaphores.
+void
+InheritanceTest()
+{
+    lockA    = new Lock("A");
+    lockB    = new Lock("B");
+    lockC    = new Lock("C");
+    midGo    = new Semaphore("midGo", 0);
+    waiterGo = new Semaphore("waiterGo", 0);
+    highGo   = new Semaphore("highGo", 0);
+    hogGo    = new Semaphore("hogGo", 0);
+    lowGo    = new Semaphore("lowGo", 0);
+
+    Thread *high = new Thread("high", true, 8);
+    (new Thread("low", false, 1))->Fork(Low, NULL);
+    (new Thread("mid", false, 3))->Fork(Mid, NULL);
+    (new Thread("waiter", false, 6))->Fork(Waiter, NULL);
+    (new Thread("hog", false, 5))->Fork(Hog, NULL);
+    (new Thread("hog", false, 5))->Fork(Hog, NULL);
+    high->Fork(High, NULL);
+    high->Join();
+}
+
+#endif
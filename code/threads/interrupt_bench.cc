@@ -0,0 +1,45 @@
+/// Benchmark of the interrupt simulation.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef INTERRUPT_BENCH
+
+#include "thread_test.hh"
+#include "system.hh"
+
+
+/// Number of interrupts kept outstanding, and number to fire in total.
+static const unsigned BENCH_OUTSTANDING = 500;
+static const unsigned BENCH_FIRINGS     = 2000000;
+
+static unsigned firings;
+
+/// Interrupt handler that schedules itself again, a random time later, so
+/// that the number of outstanding interrupts stays the same.
+static void
+BenchInterrupt(void *arg)
+{
+    if (++firings < BENCH_FIRINGS)
+        interrupt->Schedule(BenchInterrupt, arg, 1 + Random() % 1000,
+                            DISK_INT);
+}
+
+/// Measure how many interrupts per second the interrupt simulation can
+/// schedule and fire, with many of them outstanding.
+void
+InterruptBench()
+{
+    for (unsigned i = 0; i < BENCH_OUTSTANDING; i++)
+        interrupt->Schedule(BenchInterrupt, NULL, 1 + Random() % 1000,
+                            DISK_INT);
+    BenchClock clock;
+    while (firings < BENCH_FIRINGS)
+        interrupt->OneTick();
+    clock.Report("Interrupts", firings, "fired");
+    printf("%u of them outstanding at a time\n", BENCH_OUTSTANDING);
+}
+
+#endif
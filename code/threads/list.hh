@@ -3,6 +3,10 @@
 /// As in LISP, a list can contain any type of data structure as an item on
 /// the list: thread control blocks, pending interrupts, etc.
 ///
+/// Lists that are used on every context switch, such as the ready list and
+/// the queues of semaphores, are `IntrusiveList`s instead: the links live
+/// inside the items, so nothing is allocated to put an item on them.
+///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2017 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
@@ -12,6 +16,7 @@
 #define NACHOS_THREADS_LIST__HH
 
 
+#include "slab.hh"
 #include "utility.hh"
 
 
@@ -27,11 +32,24 @@ public:
     // Initialize a list element.
     ListElement(Item itemPtr, int sortKey);
 
+    /// Elements are taken from a slab, since one is allocated every time an
+    /// item is put on a list.
+    void *operator new(size_t size)
+    { return slab.Allocate("list element", size); }
+    void operator delete(void *element)
+    { slab.Free(element); }
+
     ListElement *next;  ///< Next element on list, NULL if this is the last.
     int key;            ///< Priority, for a sorted list.
     Item item;          ///< Item on the list.
+
+private:
+    static SlabAllocator slab;
 };
 
+template <class Item>
+SlabAllocator ListElement<Item>::slab;
+
 /// The following class defines a “list” -- a singly linked list of list
 /// elements, each of which points to a single item on the list.
 ///
@@ -73,6 +91,9 @@ public:
     /// Remove first item from list.
     Item SortedRemove(int *keyPtr);
 
+    /// Look at the first item, without removing it.
+    Item SortedPeek(int *keyPtr) const;
+
 private:
 
     typedef ListElement<Item> ListNode;
@@ -186,18 +207,25 @@ List<Item>::Apply(void (*func)(Item))
     }
 }
 
+/// Remove the first element holding `anotherItem` from the list, if there
+/// is one, and de-allocate it.
 template <class Item>
 void
 List<Item>::FindAndRemove(Item anotherItem)
 {
-    ListNode *ptr;
-    if (first != NULL && first->item == anotherItem){
-        first = first->next;
-    } 
-    for (ptr = first; ptr != NULL && ptr->next != NULL; ptr = ptr->next) {
-        if ((ptr->next)->item == anotherItem)
-            ptr->next = (ptr->next)->next;
-    }
+    ListNode *previous = NULL;
+
+    for (ListNode *ptr = first; ptr != NULL; previous = ptr, ptr = ptr->next)
+        if (ptr->item == anotherItem) {
+            if (previous == NULL)
+                first = ptr->next;
+            else
+                previous->next = ptr->next;
+            if (last == ptr)
+                last = previous;
+            delete ptr;
+            return;
+        }
 }
 
 /// Returns true if the list is empty (has no items).
@@ -276,5 +304,263 @@ List<Item>::SortedRemove(int *keyPtr)
     return thing;
 }
 
+/// Return the first “item” of a sorted list, leaving it on the list.
+///
+/// Returns `NULL` if nothing on the list.
+///
+/// * `keyPtr` is a pointer to the location in which to store the priority of
+///   the first item.
+template <class Item>
+Item
+List<Item>::SortedPeek(int *keyPtr) const
+{
+    if (first == NULL)
+        return Item();
+
+    if (keyPtr != NULL)
+        *keyPtr = first->key;
+    return first->item;
+}
+
+
+/// The links that let an item be on an `IntrusiveList`.
+///
+/// An item has one `ListLink` member for every intrusive list it can be on
+/// at the same time.  Internal data structures kept public so that
+/// `IntrusiveList` operations can access them directly.
+template <class Item>
+class ListLink {
+public:
+
+    /// Initialize the links of an item that is on no list.
+    ListLink()
+    {
+        next = prev = NULL;
+        list = NULL;
+    }
+
+    Item *next;        ///< Next item on the list, NULL if this is the last.
+    Item *prev;        ///< Previous item, NULL if this is the first.
+    const void *list;  ///< List the item is on, NULL if none.
+};
+
+/// The following class defines a doubly linked list of items that carry
+/// their own links, in their member `link`.  Putting an item on the list or
+/// taking it off does not allocate anything, and any item can be removed in
+/// constant time.
+///
+/// An item can be on only one list through the same link at a time.  The
+/// items are not owned by the list.
+template <class Item, ListLink<Item> Item::*link>
+class IntrusiveList {
+public:
+
+    /// Initialize the list.
+    IntrusiveList();
+
+    /// Take the items that are left off the list.
+    ~IntrusiveList();
+
+    /// Put item at the beginning of the list.
+    void Prepend(Item *item);
+
+    /// Put item at the end of the list.
+    void Append(Item *item);
+
+    /// Put item right before `before`, or at the end if it is `NULL`.
+    void InsertBefore(Item *item, Item *before);
+
+    /// Take item off the front of the list.
+    Item *Remove();
+
+    /// Remove an item, if it is on this list.
+    void FindAndRemove(Item *item);
+
+    /// Is the item on this list?
+    bool Contains(const Item *item) const;
+
+    /// Look at the first item, without removing it.
+    Item *Peek() const;
+
+    /// Return the item after `item`, or `NULL` if it is the last one.
+    Item *Next(const Item *item) const;
+
+    /// Apply `func` to all items in list.
+    void Apply(void (*func)(Item *));
+
+    /// Is the list empty?
+    bool IsEmpty() const;
+
+private:
+
+    Item *first;  ///< Head of the list, `NULL` if list is empty.
+    Item *last;   ///< Last item of list.
+};
+
+template <class Item, ListLink<Item> Item::*link>
+IntrusiveList<Item, link>::IntrusiveList()
+{
+    first = last = NULL;
+}
+
+/// Prepare a list for deallocation.
+///
+/// The items are not de-allocated, but their links are cleared, so that
+/// they can be put on another list.
+template <class Item, ListLink<Item> Item::*link>
+IntrusiveList<Item, link>::~IntrusiveList()
+{
+    while (!IsEmpty())
+        Remove();
+}
+
+/// Append an `item` to the end of the list.
+///
+/// The item must not be on another list through the same link.
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Append(Item *item)
+{
+    ListLink<Item> *l = &(item->*link);
+
+    ASSERT(l->list == NULL);
+    l->list = this;
+    l->next = NULL;
+    l->prev = last;
+    if (IsEmpty())
+        first = item;
+    else  // Put it after last.
+        (last->*link).next = item;
+    last = item;
+}
+
+/// Put an `item` on the front of the list.
+///
+/// The item must not be on another list through the same link.
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Prepend(Item *item)
+{
+    ListLink<Item> *l = &(item->*link);
+
+    ASSERT(l->list == NULL);
+    l->list = this;
+    l->prev = NULL;
+    l->next = first;
+    if (IsEmpty())
+        last = item;
+    else  // Put it before first.
+        (first->*link).prev = item;
+    first = item;
+}
+
+/// Put an `item` before `before`, which must be on the list, so that a
+/// list can be kept sorted without being walked twice.
+///
+/// The item must not be on another list through the same link.
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::InsertBefore(Item *item, Item *before)
+{
+    if (before == NULL) {
+        Append(item);
+        return;
+    }
+    ASSERT(Contains(before));
+
+    ListLink<Item> *l = &(item->*link), *b = &(before->*link);
+
+    ASSERT(l->list == NULL);
+    l->list = this;
+    l->next = before;
+    l->prev = b->prev;
+    if (b->prev == NULL)
+        first = item;
+    else
+        (b->prev->*link).next = item;
+    b->prev = item;
+}
+
+/// Remove the first item from the front of the list.
+///
+/// Returns a pointer to removed item, `NULL` if nothing on the list.
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::Remove()
+{
+    Item *item = first;
+
+    if (item != NULL)
+        FindAndRemove(item);
+    return item;
+}
+
+/// Take `item` off the list, by linking its neighbours to each other.
+/// Nothing happens if the item is not on this list.
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::FindAndRemove(Item *item)
+{
+    ListLink<Item> *l = &(item->*link);
+
+    if (l->list != this)
+        return;
+    if (l->prev != NULL)
+        (l->prev->*link).next = l->next;
+    else
+        first = l->next;
+    if (l->next != NULL)
+        (l->next->*link).prev = l->prev;
+    else
+        last = l->prev;
+    l->next = l->prev = NULL;
+    l->list = NULL;
+}
+
+template <class Item, ListLink<Item> Item::*link>
+bool
+IntrusiveList<Item, link>::Contains(const Item *item) const
+{
+    return (item->*link).list == this;
+}
+
+/// Return the first item, leaving it on the list, or `NULL` if nothing on
+/// the list.
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::Peek() const
+{
+    return first;
+}
+
+/// Return the item that follows `item`, which must be on the list, so that
+/// the list can be walked as in `Apply`.
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::Next(const Item *item) const
+{
+    ASSERT(Contains(item));
+    return (item->*link).next;
+}
+
+/// Apply a function to each item on the list.
+///
+/// * `func` is the procedure to apply to each item of the list; it must
+///   not take the item off the list.
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Apply(void (*func)(Item *))
+{
+    for (Item *ptr = first; ptr != NULL; ptr = (ptr->*link).next)
+        func(ptr);
+}
+
+template <class Item, ListLink<Item> Item::*link>
+bool
+IntrusiveList<Item, link>::IsEmpty() const
+{
+    return first == NULL;
+}
+
 
 #endif
@@ -0,0 +1,56 @@
+/// Benchmark of locks, uncontended and contended.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef LOCK_BENCH
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Number of acquire/release pairs, uncontended and contended.
+static const unsigned BENCH_PAIRS     = 10000000;
+static const unsigned BENCH_CONTENDED = 200000;
+
+static Lock *benchLock;
+
+/// Hold the lock across a yield, so that the other thread finds it taken.
+static void
+Contender(void *arg)
+{
+    for (unsigned i = 0; i < BENCH_CONTENDED; i++) {
+        benchLock->Acquire();
+        currentThread->Yield();
+        benchLock->Release();
+    }
+}
+
+/// Measure acquire/release pairs of a lock nobody else wants, and of one
+/// that two threads keep taking from each other.
+void
+LockBench()
+{
+    BenchClock clock;
+
+    benchLock = new Lock("bench");
+    clock.Restart();
+    for (unsigned i = 0; i < BENCH_PAIRS; i++) {
+        benchLock->Acquire();
+        benchLock->Release();
+    }
+    clock.Report("Uncontended lock", BENCH_PAIRS, "pairs");
+
+    Thread *t = new Thread("contender", true, currentThread->GetPriority());
+    clock.Restart();
+    t->Fork(Contender, NULL);
+    Contender(NULL);
+    t->Join();
+    clock.Report("Contended lock", 2 * BENCH_CONTENDED, "pairs");
+    delete benchLock;
+}
+
+#endif
@@ -10,8 +10,10 @@
 /// Usage
 /// =====
 ///
-///     nachos -d <debugflags> -rs <random seed #>
-///            -s -x <nachos file> -c <consoleIn> <consoleOut>
+///     nachos -d <debugflags> -rs <random seed #> -mlfq -ss <words>
+///            -p <time slice>
+///            -s -j -prof -mp <pages> -tlb <entries>
+///            -x <nachos file> -c <consoleIn> <consoleOut>
 ///            -f -cp <unix file> <nachos file>
 ///            -p <nachos file> -r <nachos file> -l -D -t
 ///            -n <network reliability> -m <machine id>
@@ -24,12 +26,23 @@
 /// * `-d` -- causes certain debugging messages to be printed (cf.
 ///   `utility.hh`).
 /// * `-rs` -- causes `Yield` to occur at random (but repeatable) spots.
+/// * `-mlfq` -- schedules threads with a multilevel feedback queue, instead
+///   of by their static priorities.
+/// * `-ss` -- sets the size of the stacks of forked threads, in words.
+/// * `-p` -- preempts the running thread at the end of every time slice,
+///   given in microseconds of host processor time.
 /// * `-z` -- prints version and copyright information, and exits.
 ///
 /// *USER_PROGRAM* options
 /// ----------------------
 ///
 /// * `-s` -- causes user programs to be executed in single-step mode.
+/// * `-j` -- translates user programs into host code as they run (x86-64
+///   hosts only).
+/// * `-prof` -- counts the instructions run, TLB misses and page faults by
+///   user program address, and reports them by routine when halting.
+/// * `-mp` -- sets the number of pages of physical memory.
+/// * `-tlb` -- sets the number of entries in the TLB, if there is one.
 /// * `-x` -- runs a user program.
 /// * `-c` -- tests the console.
 ///
@@ -0,0 +1,82 @@
+/// Test of the multilevel feedback queue with CPU-bound and I/O-bound
+/// threads.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef MLFQ_TEST
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Busy loop iterations of each CPU-bound thread, and I/O requests of the
+/// I/O-bound one, which take `MLFQ_TEST_IO_TIME` ticks each.
+static const unsigned MLFQ_TEST_WORK     = 20000;
+static const unsigned MLFQ_TEST_REQUESTS = 200;
+static const unsigned MLFQ_TEST_IO_TIME  = 300;
+
+static Semaphore *ioDone;
+static unsigned long long ioCompleted;
+
+/// Interrupt handler of the pretend device.
+static void
+IoInterrupt(void *arg)
+{
+    ioCompleted = stats->totalTicks;
+    ioDone->V();
+}
+
+/// Do nothing but let the clock run, being preempted by the timer.
+static void
+CpuBound(void *arg)
+{
+    for (unsigned i = 0; i < MLFQ_TEST_WORK; i++) {
+        interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(INT_ON);
+    }
+}
+
+/// Issue requests to a pretend device one after the other, and measure how
+/// long it takes to run again after each one completes.
+static void
+IoBound(void *arg)
+{
+    unsigned long long waited = 0, worst = 0;
+
+    for (unsigned i = 0; i < MLFQ_TEST_REQUESTS; i++) {
+        interrupt->Schedule(IoInterrupt, NULL, MLFQ_TEST_IO_TIME, DISK_INT);
+        ioDone->P();
+        unsigned long long wait = stats->totalTicks - ioCompleted;
+        waited += wait;
+        if (wait > worst)
+            worst = wait;
+    }
+    printf("I/O-bound thread: %u requests, waited %.1f ticks on average "
+           "and %llu at most to run after each\n", MLFQ_TEST_REQUESTS,
+           (double) waited / MLFQ_TEST_REQUESTS, worst);
+}
+
+/// Run CPU-bound threads and an I/O-bound one, all with the same priority.
+/// Meant to be run with `-mlfq`, and with `-rs` to compare.
+void
+MlfqTest()
+{
+    Thread *threads[4];
+
+    ioDone = new Semaphore("ioDone", 0);
+    for (unsigned i = 0; i < 3; i++) {
+        threads[i] = new Thread("cpu", true, 5);
+        threads[i]->Fork(CpuBound, NULL);
+    }
+    threads[3] = new Thread("io", true, 5);
+    threads[3]->Fork(IoBound, NULL);
+    for (unsigned i = 0; i < 4; i++)
+        threads[i]->Join();
+    interrupt->Halt();  // The timer would keep the machine from idling.
+}
+
+#endif
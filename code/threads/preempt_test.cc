@@ -0,0 +1,56 @@
+/// Test of preempting threads that never yield.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef PREEMPT_TEST
+
+#include "thread_test.hh"
+#include "system.hh"
+
+
+/// Number of times the spinning threads must take turns.
+static const unsigned PREEMPT_TURNS = 20;
+
+static volatile bool     stopSpinning;
+static volatile unsigned lastSpinner, turns;
+
+/// Spin without ever yielding, noting whenever the other spinner ran last.
+static void
+Spinner(void *which_)
+{
+    unsigned which = (unsigned) (long) which_;
+
+    while (!stopSpinning)
+        if (lastSpinner != which) {
+            lastSpinner = which;
+            turns++;
+        }
+}
+
+/// Check that two threads that never give up the processor still take
+/// turns.  Run with `-p`; otherwise, it never ends.
+void
+PreemptTest()
+{
+    Thread *other = new Thread("spinner", true, 9);
+
+    stopSpinning = false;
+    lastSpinner  = 0;
+    turns        = 0;
+    BenchClock clock;
+    other->Fork(Spinner, (void *) 1);
+    while (turns < PREEMPT_TURNS)
+        if (lastSpinner != 0) {
+            lastSpinner = 0;
+            turns++;
+        }
+    stopSpinning = true;
+    other->Join();
+    printf("Spinning threads took %u turns in %.3f s\n", turns,
+           clock.Seconds());
+}
+
+#endif
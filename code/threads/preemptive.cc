@@ -11,162 +11,107 @@
 // Access to global objects: `currentThread`, `interrupt`...
 #include "system.hh"
 
-// UNIX and Linux-specific headers.
-#include <unistd.h>
-#include <sys/ptrace.h>
-#include <sys/wait.h>
-#include <sys/user.h>
+// UNIX-specific headers.
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/time.h>
 
 
-static void ContextSwitch();
-static void MonitorProcess(int childPid, unsigned long timeSliceLength);
-static void LetMeBeMonitored();
+static void ContextSwitch(int sig, siginfo_t *info, void *context);
 
-static bool inContextSwitch = false;
+/// Bounds of the code of Nachos itself, set by the linker.
+extern char __executable_start[], etext[];
+
+/// Set while the handler decides what to do, so that a signal arriving in
+/// the meantime is ignored instead of nesting.
+static volatile sig_atomic_t inContextSwitch = false;
+
+volatile sig_atomic_t preemptionRequested = 0;
 
 /// Set up the preemptive scheduler.
 ///
-/// * `timeSliceLength` means how many machine instructions will last the
-///   time slice for every kernel thread.
-void PreemptiveScheduler::SetUp( unsigned long timeSliceLength)
+/// The timer counts processor time used by Nachos, so that slices do not
+/// expire while the host is running something else.  The signal is not
+/// blocked while the handler runs, because it may switch to a thread that
+/// does not return from it for a long time.
+///
+/// * `timeSliceLength` means how many microseconds will last the time slice
+///   for every kernel thread.
+void
+PreemptiveScheduler::SetUp(unsigned long timeSliceLength)
 {
-    int childPid = fork();
-    switch (childPid) {
-        case -1:
-            DEBUG('p',
-                  "Preemptive scheduler: unable to launch child process\n");
-            ASSERT(false);
-            break;
-
-        // Child process: original Nachos code.
-        case 0:
-            LetMeBeMonitored();
-            // Resume Nachos execution as a child process.
-            return;
-
-        // Parent process: monitor code.
-        default:
-            MonitorProcess(childPid, timeSliceLength);
-    }
+    struct sigaction action;
+    memset(&action, 0, sizeof action);
+    action.sa_sigaction = ContextSwitch;
+    action.sa_flags     = SA_SIGINFO | SA_NODEFER | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGVTALRM, &action, NULL);
+
+    struct itimerval slice;
+    slice.it_interval.tv_sec  = timeSliceLength / 1000000;
+    slice.it_interval.tv_usec = timeSliceLength % 1000000;
+    slice.it_value            = slice.it_interval;
+    setitimer(ITIMER_VIRTUAL, &slice, NULL);
+
+    DEBUG('p', "Preemptive scheduler: time slice of %lu microseconds\n",
+          timeSliceLength);
 }
 
-
-void LetMeBeMonitored()
+PreemptiveScheduler::~PreemptiveScheduler()
 {
-    // Allow the parent process to ptrace me.
-    ptrace(PTRACE_TRACEME, 0, NULL, NULL);
-
-    DEBUG ('p', "Preemptive scheduler: child process will be ptraced\n");
-
-    // Raise a signal to bring back control to the parent.
-    raise(SIGUSR1);
+    struct itimerval none;
+    memset(&none, 0, sizeof none);
+    setitimer(ITIMER_VIRTUAL, &none, NULL);
+    signal(SIGVTALRM, SIG_DFL);
 }
 
-
-void MonitorProcess(int childPid, unsigned long timeSliceLength)
+/// Return true if the thread was interrupted in the code of Nachos.
+///
+/// Anywhere else, it may be inside the C library, holding one of its locks
+/// (say, the one of `malloc`), and the next thread would find it taken or,
+/// worse, the data it protects half updated.
+static bool
+InNachosCode(void *context)
 {
-    // Machine instruction counter.
-    long long instructionCounter = 1;
-
-    while (true) {
-
-        // Wait for child process.
-        int wait_val;
-        wait(&wait_val);
-        if (WIFEXITED(wait_val)) {
-            DEBUG('p', "Preemptive scheduler: child process terminated\n");
-            break;
-        }
-
-        // Increment instruction counter.
-        instructionCounter++;
-
-        // From time to time, insert machine code to force a context switch.
-        if (instructionCounter % timeSliceLength == 0)
-        {
-            // Get child value of `inContextSwitch`.
-            long incs = ptrace(PTRACE_PEEKDATA, childPid,
-                               (long) &inContextSwitch, NULL);
-
-            if (incs == 0) {
-                DEBUG('p', "Preemptive scheduler: "
-                           "forcing a context switch at instruction %lld\n",
-                      instructionCounter );
-
-                struct user_regs_struct regs;
-
-                // Get child process registers.
-                ptrace ( PTRACE_GETREGS,  childPid, NULL, &regs );
-
-                // Build a call stack frame by inserting EIP/RIP on top of
-                // the stack.
-#ifdef HOST_i386
-                regs.esp = regs.esp - 4;
-                ptrace(PTRACE_POKEDATA, childPid, regs.esp, regs.eip);
-                // Force a jump to `ContextSwitch`.
-                regs.eip = (long) ContextSwitch;
-#elif defined(HOST_x86_64)
-                regs.rsp = regs.rsp - 8;
-                ptrace(PTRACE_POKEDATA, childPid, regs.rsp, regs.rip);
-                // Force a jump to ContextSwitch`.
-                regs.rip = (long long) ContextSwitch;
+#ifdef HOST_x86_64
+    const char *pc = (const char *)
+      ((ucontext_t *) context)->uc_mcontext.gregs[REG_RIP];
+#elif defined(HOST_i386)
+    const char *pc = (const char *)
+      ((ucontext_t *) context)->uc_mcontext.gregs[REG_EIP];
+#else
+    const char *pc = __executable_start;  // Cannot tell; assume it is.
 #endif
-
-                // Store new register values in the child process. The child
-                // will now make a call to `ContextSwitch`.
-                ptrace(PTRACE_SETREGS, childPid, NULL, &regs);
-            }
-        }
-
-        // Resume child execution.
-        ptrace(PTRACE_SINGLESTEP, childPid, NULL, NULL);
-    }
-
-    DEBUG('p', "Preemptive scheduler: Finished\n");
-    exit(0);
+    return pc >= __executable_start && pc < etext;
 }
 
-
 /// Force a context switch.
 ///
-/// This call is made asynchronously from the parent process, using `ptrace`
-/// features.
-static void ContextSwitch(void)
+/// This is the handler of the timer signal, so it runs on top of whatever
+/// the current thread was doing, and the yield returns here when the thread
+/// is scheduled again.
+static void
+ContextSwitch(int sig, siginfo_t *info, void *context)
 {
-    // Prevent register loss: save all registers.
-#ifdef HOST_i386
-    __asm__ ("pushal");
-    __asm__ ("subl $8, %esp");
-#elif defined(HOST_x86_64)
-    // Push all registers.
-    __asm__ ("push %rax; push %rbx; push %rcx; push %rdx");
-    __asm__ ("push %rsi; push %rdi; push %rsp; push %rbp");
-    __asm__ ("push %r8; push %r9; push %r10; push %r11;"
-             " push %r12; push %r13; push %r14; push %r15");
-    __asm__ ("sub $16, %rsp");
-#endif
-
+    if (inContextSwitch)
+        return;
+    if (interrupt->getStatus() == USER_MODE) {
+        preemptionRequested = true;  // See `Machine::Run`.
+        return;
+    }
     inContextSwitch = true;
 
-    // Make a context switch if interrupts are enabled.
-    if (interrupt->getLevel() == INT_ON) {
+    // Make a context switch if it is safe; otherwise, the kernel is in a
+    // critical section (interrupts are disabled) or in the C library, so
+    // wait until it enables interrupts again, or for the next slice.
+    if (interrupt->getLevel() == INT_ON && InNachosCode(context)) {
         inContextSwitch = false;
+        MachineStatus old = interrupt->getStatus();
+        interrupt->setStatus(SYSTEM_MODE);  // Yield is a kernel routine.
         currentThread->Yield();
+        interrupt->setStatus(old);
     } else {
         interrupt->YieldOnReturn();
         inContextSwitch = false;
     }
-
-    // Restore old register values.
-#ifdef HOST_i386
-    __asm__ ("addl $8, %esp");
-    __asm__ ("popal");
-#elif defined(HOST_x86_64)
-    __asm__ ("add $16, %rsp");
-    // Pop all registers.
-    __asm__ ("pop %r15; pop %r14; pop %r13; pop %r12;"
-             " pop %r11; pop %r10; pop %r9; pop %r8");
-    __asm__ ("pop %rbp; pop %rsp; pop %rdi; pop %rsi");
-    __asm__ ( "pop %rdx; pop %rcx; pop %rbx; pop %rax" );
-#endif
 }
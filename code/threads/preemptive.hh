@@ -1,6 +1,9 @@
 /// Extension to make kernel threads be periodically preempted.
 ///
-/// It only works on Linux x86 environments.
+/// A host interval timer delivers a signal at the end of every time slice,
+/// and its handler makes the running thread yield.  If the kernel is in a
+/// critical section (interrupts are disabled), the yield is postponed until
+/// interrupts are enabled again, as the timer device would.
 ///
 /// Copyright (c) 2007      Universidad de Las Palmas de Gran Canaria.
 ///               2016-2017 Docentes de la Universidad Nacional de Rosario.
@@ -13,19 +16,28 @@
 #define NACHOS_THREADS_PREEMPTIVE__HH
 
 
+#include <signal.h>
+
+
+/// Raised when a slice ends while a user program is being simulated.  The
+/// simulator may be running a batch of instructions whose ticks are not
+/// charged yet, so the handler cannot yield there; the simulator checks
+/// this between blocks, and yields itself.
+extern volatile sig_atomic_t preemptionRequested;
+
 class PreemptiveScheduler {
 public:
 
     PreemptiveScheduler()
     {}
 
-    ~PreemptiveScheduler()
-    {}
+    /// Stop time slicing, if it was set up.
+    ~PreemptiveScheduler();
 
     /// Set up time slicing between kernel threads.
     ///
-    /// * `timeSliceLength` is the time slice duration, measured in native
-    ///   x86 machine instructions.
+    /// * `timeSliceLength` is the time slice duration, measured in
+    ///   microseconds of host processor time.
     void SetUp(unsigned long timeSliceLength);
 
 };
@@ -0,0 +1,113 @@
+/// Test of readers-writer locks.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef RWLOCK_TEST
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Number of yields the CPU-bound thread of medium priority does.
+static const unsigned RW_HOG_ROUNDS = 1000;
+
+static RWLock    *rwLock;
+static Semaphore *readersIn, *lateGo, *rwDone;
+static volatile bool writerWaits, writerDone;
+static unsigned  activeReaders, maxActiveReaders, rwHogYields;
+
+/// Reads along with the other reader, until the writer and the late reader
+/// wait behind them; they must lend it their priority.
+static void
+Reader(void *arg)
+{
+    rwLock->AcquireRead();
+    activeReaders++;
+    if (activeReaders > maxActiveReaders)
+        maxActiveReaders = activeReaders;
+    Say("reading");
+    readersIn->V();
+    while (!writerWaits)
+        currentThread->Yield();
+    lateGo->V();
+    currentThread->Yield();
+    Say("done reading");
+    ASSERT(currentThread->GetPriority() == 8);
+    activeReaders--;
+    rwLock->ReleaseRead();
+    rwDone->V();
+}
+
+static void
+Writer(void *arg)
+{
+    Say("waits to write");
+    writerWaits = true;
+    rwLock->AcquireWrite();
+    Say("writing");
+    ASSERT(activeReaders == 0);
+    // Under the multilevel feedback queue, a yield only hands the CPU to
+    // threads of at least the same priority, so the readers, lent the
+    // priority of the waiters, keep the hog out until now; otherwise their
+    // own yields let it in.
+    if (scheduler->GetPolicy() == MULTILEVEL_FEEDBACK)
+        ASSERT(rwHogYields == 0);
+    writerDone = true;
+    rwLock->ReleaseWrite();
+    rwDone->V();
+}
+
+/// Comes while the writer waits, so it has to wait as well, even though
+/// the lock is held for reading.
+static void
+LateReader(void *arg)
+{
+    lateGo->P();
+    Say("waits to read");
+    rwLock->AcquireRead();
+    Say("reading");
+    ASSERT(writerDone);
+    rwLock->ReleaseRead();
+    rwDone->V();
+}
+
+static void
+RwHog(void *arg)
+{
+    for (unsigned i = 0; i < RW_HOG_ROUNDS; i++) {
+        rwHogYields++;
+        currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+/// Check that readers share the lock, that a waiting writer keeps new
+/// readers out, and that holders inherit the priority of waiters.
+void
+RWLockTest()
+{
+    rwLock    = new RWLock("rw");
+    readersIn = new Semaphore("readersIn", 0);
+    lateGo    = new Semaphore("lateGo", 0);
+    rwDone    = new Semaphore("rwDone", 0);
+
+    (new Thread("reader", false, 2))->Fork(Reader, NULL);
+    (new Thread("reader", false, 2))->Fork(Reader, NULL);
+    readersIn->P();
+    readersIn->P();
+    (new Thread("writer", false, 7))->Fork(Writer, NULL);
+    (new Thread("late", false, 8))->Fork(LateReader, NULL);
+    (new Thread("hog", false, 5))->Fork(RwHog, NULL);
+    for (unsigned i = 0; i < 5; i++)
+        rwDone->P();
+
+    printf("Readers held the lock %u at a time\n", maxActiveReaders);
+    ASSERT(maxActiveReaders == 2);
+    delete rwLock;
+}
+
+#endif
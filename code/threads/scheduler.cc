@@ -19,23 +19,30 @@
 
 
 #include "scheduler.hh"
+#include "synch.hh"
 #include "system.hh"
 
 
 /// Initialize the list of ready but not running threads to empty.
-Scheduler::Scheduler()
+///
+/// * `schedulingPolicy` tells how the priorities of threads change.
+Scheduler::Scheduler(SchedulingPolicy schedulingPolicy)
 {
-    for (int i=0;i<NUMBER_OF_PRIORITIES;i++){
-        readyList[i] = new List<Thread*>;
+    ASSERT(NUMBER_OF_PRIORITIES <= 8 * sizeof readyLevels);
+    readyLevels = 0;
+    policy      = schedulingPolicy;
+    busyTicks   = 0;
+    boostEpoch  = 0;
+    nextBoost   = MLFQ_BOOST_PERIOD;
+    if (policy == MULTILEVEL_FEEDBACK) {
+        ASSERT(NUMBER_OF_PRIORITIES <= MAX_SCHEDULING_LEVELS);
+        stats->numLevels = NUMBER_OF_PRIORITIES;
     }
 }
 
 /// De-allocate the list of ready threads.
 Scheduler::~Scheduler()
 {
-    for (int i=0;i<NUMBER_OF_PRIORITIES;i++){
-        delete readyList[i];
-    } 
 }
 
 /// Mark a thread as ready, but not running.
@@ -47,41 +54,152 @@ Scheduler::ReadyToRun(Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
+    if (policy == MULTILEVEL_FEEDBACK && thread->boostEpoch != boostEpoch) {
+        // It was blocked during a boost.
+        thread->boostEpoch = boostEpoch;
+        SetLevel(thread, thread->GetBasePriority());
+    }
     thread->setStatus(READY);
-    readyList[thread->GetPriority()]->Append(thread);
+    readyList[thread->GetPriority()].Append(thread);
+    readyLevels |= 1U << thread->GetPriority();
 }
 
 /// Return the next thread to be scheduled onto the CPU.
 ///
 /// If there are no ready threads, return `NULL`.
 ///
+/// The highest priority with ready threads is the highest bit set in
+/// `readyLevels`, so no list has to be looked at to find it.
+///
 /// Side effect: thread is removed from the ready list.
 Thread *
 Scheduler::FindNextToRun()
 {
-    for(int i=NUMBER_OF_PRIORITIES-1;i>=0;i--){
-        if(!readyList[i]->IsEmpty())
-            return readyList[i]->Remove();
-    }
-    return NULL;
+    if (readyLevels == 0)
+        return NULL;
+
+    int     level  = 8 * sizeof readyLevels - 1 - __builtin_clz(readyLevels);
+    Thread *thread = readyList[level].Remove();
+    if (readyList[level].IsEmpty())
+        readyLevels &= ~(1U << level);
+    return thread;
+}
+
+/// The link of a ready thread tells which list it is on, so this takes
+/// constant time.
+int
+Scheduler::ReadyLevel(const Thread *thread) const
+{
+    const void *list = thread->queueLink.list;
+
+    if (list < &readyList[0] || list >= &readyList[NUMBER_OF_PRIORITIES])
+        return -1;  // On no list, or waiting on a semaphore.
+    return (const IntrusiveList<Thread, &Thread::queueLink> *) list
+           - readyList;
 }
 
 /// Move a thread to another priority list in order to 
 /// avoid inversion of priorities
+///
+/// Only a thread that is on a ready list is moved; a blocked one stays
+/// where it is waiting, and is queued by its new priority when woken.
 
 void
 Scheduler::ChangePriority(Thread* thread) {
-    readyList[thread->GetRealPriority()]->FindAndRemove(thread);
+    int level = ReadyLevel(thread);
+
+    if (level < 0 || level == thread->GetPriority())
+        return;
+    readyList[level].FindAndRemove(thread);
+    if (readyList[level].IsEmpty())
+        readyLevels &= ~(1U << level);
     ReadyToRun(thread);
 }
 
-/// Return a thread to its real priority
+/// Charge the running thread for the time since the last charge, and move
+/// it down one priority if it used up its quantum.  The quantum is longer
+/// the lower the priority.  Boost every thread when it is time.
+void
+Scheduler::TimerTick()
+{
+    if (policy != MULTILEVEL_FEEDBACK)
+        return;
 
+    Charge(currentThread);
+    int level = currentThread->GetRealPriority();
+    if (currentThread->quantumTicks
+          >= MLFQ_QUANTUM * (NUMBER_OF_PRIORITIES - level)) {
+        DEBUG('t', "Thread %s used up its quantum at priority %d\n",
+              currentThread->getName(), level);
+        SetLevel(currentThread, level > 0 ? level - 1 : 0);
+    }
+    if (stats->totalTicks >= nextBoost)
+        BoostAll();
+}
+
+/// Under the multilevel feedback queue, a thread that blocks gave up the
+/// CPU to wait, for I/O most likely, so it moves up one priority, never
+/// above its base one, with a new quantum.
+///
+/// This cannot wait until the next thread is dispatched: if nothing else is
+/// ready, the thread may have been woken up while the CPU idled, and it
+/// would look as if it had been preempted.
 void
-Scheduler::RestorePriority(Thread* thread) {
-    readyList[thread->GetPriority()]->FindAndRemove(thread);
-    thread->RestorePriority();
-    ReadyToRun(thread);
+Scheduler::Block(Thread *thread)
+{
+    if (policy != MULTILEVEL_FEEDBACK)
+        return;
+
+    Charge(thread);
+    int level = thread->GetRealPriority();
+    SetLevel(thread, level < thread->GetBasePriority() ? level + 1 : level);
+}
+
+/// Idle time is not charged to anyone.
+void
+Scheduler::Charge(Thread *thread)
+{
+    unsigned long long busy = stats->totalTicks - stats->idleTicks;
+    unsigned long long ran  = busy - busyTicks;
+
+    busyTicks = busy;
+    stats->levelTicks[thread->GetRealPriority()] += ran;
+    thread->quantumTicks += ran;
+}
+
+/// The priority that `thread` runs with is recomputed, since it may also
+/// inherit one through the locks it holds.
+void
+Scheduler::SetLevel(Thread *thread, int level)
+{
+    thread->quantumTicks = 0;
+    if (level == thread->GetRealPriority())
+        return;
+    thread->SetRealPriority(level);
+    Lock::RecomputePriority(thread);
+}
+
+/// Ready threads are put back on the lists right away; blocked ones are
+/// reset when they become ready, as they will find that their `boostEpoch`
+/// is old.
+void
+Scheduler::BoostAll()
+{
+    IntrusiveList<Thread, &Thread::queueLink> ready;
+
+    DEBUG('t', "Boosting every thread to its base priority\n");
+    boostEpoch++;
+    nextBoost = stats->totalTicks + MLFQ_BOOST_PERIOD;
+
+    for (int i = NUMBER_OF_PRIORITIES - 1; i >= 0; i--)
+        while (!readyList[i].IsEmpty())
+            ready.Append(readyList[i].Remove());
+    readyLevels = 0;
+
+    currentThread->boostEpoch = boostEpoch;
+    SetLevel(currentThread, currentThread->GetBasePriority());
+    while (!ready.IsEmpty())
+        ReadyToRun(ready.Remove());
 }
 
 /// Dispatch the CPU to `nextThread`.
@@ -100,6 +218,9 @@ Scheduler::Run(Thread *nextThread)
 {
     Thread *oldThread = currentThread;
 
+    if (policy == MULTILEVEL_FEEDBACK)
+        Charge(oldThread);
+
 #ifdef USER_PROGRAM  // Ignore until running user programs.
     if (currentThread->space != NULL) {
         // If this thread is a user program, save the user's CPU registers.
@@ -161,7 +282,7 @@ Scheduler::Print()
     printf("Ready list contents:\n");
     for(i=0;i<NUMBER_OF_PRIORITIES;i++){
         printf("Priority %d: ",i);
-        readyList[i]->Apply(ThreadPrint);
+        readyList[i].Apply(ThreadPrint);
         printf("\n");
     }
 }
@@ -15,8 +15,27 @@
 
 #include "list.hh"
 #include "thread.hh"
+#include "machine/statistics.hh"
 
 
+/// Scheduling policies that can be chosen at startup.
+enum SchedulingPolicy {
+    STATIC_PRIORITIES,   ///< Threads keep the priority they were created
+                         ///< with, except for what they inherit.
+    MULTILEVEL_FEEDBACK  ///< Threads that use up their quantum are moved
+                         ///< down one priority, and threads that block are
+                         ///< moved back up, never above the priority they
+                         ///< were created with.
+};
+
+/// Ticks a thread may run at the top priority before being moved down,
+/// under `MULTILEVEL_FEEDBACK`; each priority below gets one more of these.
+const unsigned MLFQ_QUANTUM = TIMER_TICKS;
+
+/// Ticks between two resets of every thread to the priority it was created
+/// with, so that threads moved down do not starve.
+const unsigned MLFQ_BOOST_PERIOD = 50 * TIMER_TICKS;
+
 /// The following class defines the scheduler/dispatcher abstraction --
 /// the data structures and operations needed to keep track of which
 /// thread is running, and which threads are ready but not running.
@@ -24,7 +43,7 @@ class Scheduler {
 public:
 
     /// Initialize list of ready threads.
-    Scheduler();
+    Scheduler(SchedulingPolicy schedulingPolicy = STATIC_PRIORITIES);
 
     /// De-allocate ready list.
     ~Scheduler();
@@ -41,15 +60,54 @@ public:
     /// Move a process to another priority list
     void ChangePriority(Thread* thread);
 
-    void RestorePriority(Thread* thread);
+    SchedulingPolicy GetPolicy() const
+    {
+        return policy;
+    }
+
+    /// Called by the timer interrupt handler, to charge the running thread
+    /// for its quantum.
+    void TimerTick();
+
+    /// Called by `Thread::Sleep` when the running thread blocks, before
+    /// anything can wake it up again.
+    void Block(Thread *thread);
 
     // Print contents of ready list.
     void Print();
 
 private:
 
-    // Queue of threads that are ready to run, but not running.
-    List<Thread*> *readyList[NUMBER_OF_PRIORITIES];
+    /// Return the priority of the ready list `thread` is on, or -1 if it is
+    /// not ready.
+    int ReadyLevel(const Thread *thread) const;
+
+    /// Routines for the multilevel feedback queue.
+
+    /// Charge `thread` for the time run since the last charge.
+    void Charge(Thread *thread);
+
+    /// Put `thread` at priority `level`, with a new quantum.
+    void SetLevel(Thread *thread, int level);
+
+    /// Move every thread back to the priority it was created with.
+    void BoostAll();
+
+    SchedulingPolicy policy;
+
+    /// Queues of threads that are ready to run, but not running, one for
+    /// every priority.
+    IntrusiveList<Thread, &Thread::queueLink> readyList[NUMBER_OF_PRIORITIES];
+
+    /// Bit `i` is set if `readyList[i]` is not empty.
+    unsigned readyLevels;
+
+    /// Ticks not spent idle, up to the last charge.
+    unsigned long long busyTicks;
+
+    /// Number of boosts so far, and when the next one is due.
+    unsigned boostEpoch;
+    unsigned long long nextBoost;
 
 };
 
@@ -0,0 +1,90 @@
+/// Routines to allocate kernel objects of a kind from slabs.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "slab.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+SlabAllocator *SlabAllocator::allocators = NULL;
+
+/// Interrupts are disabled, as for any data shared among threads, once
+/// there are interrupts: objects may be allocated by the constructors of
+/// static objects, before Nachos is initialized.
+void *
+SlabAllocator::Allocate(const char *debugName, size_t size)
+{
+    IntStatus oldLevel = interrupt != NULL ? interrupt->SetLevel(INT_OFF)
+                                           : INT_OFF;
+
+    if (objectSize == 0) {  // First use.
+        const size_t align = sizeof (void *);
+        name       = debugName;
+        objectSize = (size < align ? align : size + align - 1) & ~(align - 1);
+        nextAllocator = allocators;
+        allocators    = this;
+    }
+    ASSERT(size <= objectSize);
+
+    if (freeObjects == NULL)
+        Grow();
+    void *object = freeObjects;
+    freeObjects  = *(void **) object;
+    allocations++;
+    if (++inUse > maxInUse)
+        maxInUse = inUse;
+
+    if (interrupt != NULL)
+        interrupt->SetLevel(oldLevel);
+    return object;
+}
+
+void
+SlabAllocator::Free(void *object)
+{
+    if (object == NULL)
+        return;
+
+    IntStatus oldLevel = interrupt != NULL ? interrupt->SetLevel(INT_OFF)
+                                           : INT_OFF;
+
+    ASSERT(inUse > 0);
+    *(void **) object = freeObjects;
+    freeObjects = object;
+    inUse--;
+
+    if (interrupt != NULL)
+        interrupt->SetLevel(oldLevel);
+}
+
+/// Objects are linked so that the first one handed out is the lowest.
+void
+SlabAllocator::Grow()
+{
+    unsigned count = SLAB_SIZE / objectSize;
+    if (count == 0)
+        count = 1;
+
+    char *slab = new char[count * objectSize];
+    for (unsigned i = count; i-- > 0; ) {
+        void *object = slab + i * objectSize;
+        *(void **) object = freeObjects;
+        freeObjects = object;
+    }
+    numSlabs++;
+}
+
+void
+SlabAllocator::PrintAll()
+{
+    printf("\nSlab allocators:\n%14s %10s %10s %8s %6s  %s\n", "allocations",
+           "in use", "max in use", "slabs", "size", "object");
+    for (SlabAllocator *a = allocators; a != NULL; a = a->nextAllocator)
+        printf("%14llu %10u %10u %8u %6u  %s\n", a->allocations, a->inUse,
+               a->maxInUse, a->numSlabs, (unsigned) a->objectSize, a->name);
+}
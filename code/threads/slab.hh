@@ -0,0 +1,82 @@
+/// Data structures to allocate kernel objects of a kind from slabs.
+///
+/// Some kernel objects come and go all the time -- list elements, mail,
+/// file headers, and so on.  Instead of asking the host allocator for each
+/// of them, every kind of object gets a `SlabAllocator`, which takes memory
+/// from the host a slab of many objects at a time, and keeps the objects
+/// freed in a list, to hand them out again.  Objects are never given back
+/// to the host.
+///
+/// A class uses one by defining its own `operator new` and `operator
+/// delete`:
+///
+///     void *operator new(size_t size) { return slab.Allocate("x", size); }
+///     void operator delete(void *x) { slab.Free(x); }
+///     static SlabAllocator slab;
+///
+/// Allocating and freeing disable interrupts, like every other kernel
+/// structure shared among threads.
+///
+/// With the `h` debugging flag, the counts of every allocator are reported
+/// at shutdown.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_SLAB__HH
+#define NACHOS_THREADS_SLAB__HH
+
+
+#include <stddef.h>
+
+
+/// Bytes taken from the host at a time, unless a single object is larger.
+const unsigned SLAB_SIZE = 8192;
+
+/// The following class defines an allocator of objects of a single size.
+///
+/// It has no constructor: one that is all zeros, as static ones are before
+/// any constructor runs, is ready to use, so objects can be allocated from
+/// it by the constructors of other static objects.  The name and size are
+/// set by the first allocation.
+class SlabAllocator {
+public:
+
+    /// Return room for an object of `size` bytes, which must be the same
+    /// every time.  `debugName` is only kept the first time.
+    void *Allocate(const char *debugName, size_t size);
+
+    /// Put an object returned by `Allocate` back, to be handed out again.
+    /// Nothing happens for `NULL`.
+    void Free(void *object);
+
+    /// Print the counts of every allocator used so far.
+    static void PrintAll();
+
+private:
+
+    /// Take a slab from the host and put its objects in the free list.
+    void Grow();
+
+    const char *name;
+    size_t      objectSize;
+
+    /// Free objects, linked through their first word.
+    void *freeObjects;
+
+    unsigned long long allocations;
+    unsigned inUse;
+    unsigned maxInUse;
+    unsigned numSlabs;
+
+    /// Next allocator used, in `allocators`.
+    SlabAllocator *nextAllocator;
+
+    /// Every allocator used so far, for `PrintAll`.
+    static SlabAllocator *allocators;
+
+};
+
+
+#endif
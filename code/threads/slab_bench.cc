@@ -0,0 +1,91 @@
+/// Benchmark of the slab allocator.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef SLAB_BENCH
+
+#include "thread_test.hh"
+#include "slab.hh"
+#include "list.hh"
+#include "system.hh"
+
+
+/// Number of objects allocated, and how many are kept at a time.
+static const unsigned SLAB_OBJECTS = 4000000;
+static const unsigned SLAB_AT_ONCE = 64;
+
+/// Objects the size of a list element holding a few words, from the host
+/// allocator and from a slab.
+struct HostObject {
+    long words[6];
+};
+
+struct SlabObject {
+    long words[6];
+
+    void *operator new(size_t size)
+    { return slab.Allocate("bench object", size); }
+    void operator delete(void *object)
+    { slab.Free(object); }
+
+    static SlabAllocator slab;
+};
+
+SlabAllocator SlabObject::slab;
+
+/// Allocate and free `SLAB_OBJECTS` objects in batches, timing it.
+template <class Object>
+static void
+AllocateObjects(const char *what)
+{
+    Object *batch[SLAB_AT_ONCE];
+    long    sum = 0;
+
+    BenchClock clock;
+    for (unsigned i = 0; i < SLAB_OBJECTS; i += SLAB_AT_ONCE) {
+        for (unsigned j = 0; j < SLAB_AT_ONCE; j++) {
+            batch[j] = new Object;
+            batch[j]->words[0] = j;
+        }
+        for (unsigned j = 0; j < SLAB_AT_ONCE; j++) {
+            sum += batch[j]->words[0];
+            delete batch[j];
+        }
+    }
+    clock.Report(what, SLAB_OBJECTS, "objects");
+    ASSERT(sum == (long) (SLAB_OBJECTS / SLAB_AT_ONCE)
+                  * (SLAB_AT_ONCE * (SLAB_AT_ONCE - 1) / 2));
+}
+
+/// Allocate and free objects from the host and from a slab, and check that
+/// the slab hands freed objects out again; then time putting items on a
+/// list, whose elements now come from a slab.
+void
+SlabBench()
+{
+    AllocateObjects<HostObject>("Host new/delete");
+    AllocateObjects<SlabObject>("Slab new/delete");
+
+    SlabObject *first = new SlabObject;
+    delete first;
+    SlabObject *again = new SlabObject;
+    ASSERT(again == first);
+    delete again;
+
+    List<long> list;
+    BenchClock clock;
+    for (unsigned i = 0; i < SLAB_OBJECTS; i += SLAB_AT_ONCE) {
+        for (unsigned j = 0; j < SLAB_AT_ONCE; j++)
+            list.Append(j);
+        for (unsigned j = 0; j < SLAB_AT_ONCE; j++)
+            ASSERT(list.Remove() == (long) j);
+    }
+    clock.Report("List append/remove", SLAB_OBJECTS, "items");
+
+    SlabAllocator::PrintAll();
+}
+
+#endif
@@ -0,0 +1,112 @@
+/// Routines to allocate the execution stacks of threads.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "stack_pool.hh"
+#include "system.hh"
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+/// Stack for the handler of `SIGSEGV`, since the one of the thread that
+/// overflowed cannot be used.
+static char signalStack[64 * 1024];
+
+/// Report an overflow if the faulting address is below a stack, and abort;
+/// otherwise, let the fault happen again without this handler.
+static void
+SegmentationFaultHandler(int sig, siginfo_t *info, void *context)
+{
+    if (stackPool != NULL && stackPool->IsOverflow(info->si_addr)) {
+        fprintf(stderr, "Stack overflow in thread \"%s\"; try a larger "
+                "stack with `-ss`.\n", currentThread != NULL
+                  ? currentThread->getName() : "?");
+        Abort();
+    }
+    signal(SIGSEGV, SIG_DFL);
+}
+
+StackPool::StackPool(unsigned size)
+{
+    pageSize   = getpagesize();
+    stackSize  = divRoundUp(size, pageSize) * pageSize;
+    freeStacks = NULL;
+    stacks     = NULL;
+    numStacks  = 0;
+    maxStacks  = 0;
+
+    stack_t altStack;
+    altStack.ss_sp    = signalStack;
+    altStack.ss_size  = sizeof signalStack;
+    altStack.ss_flags = 0;
+    sigaltstack(&altStack, NULL);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof action);
+    action.sa_sigaction = SegmentationFaultHandler;
+    action.sa_flags     = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, NULL);
+}
+
+StackPool::~StackPool()
+{
+    for (unsigned i = 0; i < numStacks; i++)
+        munmap(stacks[i] - pageSize, pageSize + stackSize);
+    delete [] stacks;
+}
+
+/// A new stack is mapped together with the page below it, which is then
+/// protected.
+char *
+StackPool::Allocate()
+{
+    if (freeStacks != NULL) {
+        char *stack = freeStacks;
+        freeStacks = *(char **) stack;
+        return stack;
+    }
+
+    void *mapping = mmap(NULL, pageSize + stackSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT(mapping != MAP_FAILED);
+    mprotect(mapping, pageSize, PROT_NONE);
+
+    if (numStacks == maxStacks) {
+        maxStacks = maxStacks == 0 ? 16 : 2 * maxStacks;
+        char **bigger = new char *[maxStacks];
+        if (numStacks > 0)
+            memcpy(bigger, stacks, numStacks * sizeof *stacks);
+        delete [] stacks;
+        stacks = bigger;
+    }
+    stacks[numStacks++] = (char *) mapping + pageSize;
+    return (char *) mapping + pageSize;
+}
+
+void
+StackPool::Free(char *stack)
+{
+    ASSERT(stack != NULL);
+    *(char **) stack = freeStacks;
+    freeStacks = stack;
+}
+
+/// Faults are only possible where nothing is mapped, so anything within a
+/// stack's size below the guard page is taken to be a frame that jumped
+/// over it; the mappings of other stacks never fault.
+bool
+StackPool::IsOverflow(const void *addr) const
+{
+    const char *fault = (const char *) addr;
+
+    for (unsigned i = 0; i < numStacks; i++)
+        if (fault < stacks[i] && fault >= stacks[i] - pageSize - stackSize)
+            return true;
+    return false;
+}
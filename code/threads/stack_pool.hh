@@ -0,0 +1,64 @@
+/// Data structures to allocate the execution stacks of threads.
+///
+/// Stacks are mapped directly from the host, with a page below each one
+/// that cannot be accessed, so that a thread that overflows its stack is
+/// caught right away instead of silently corrupting whatever comes below.
+/// Setting up those mappings is expensive compared to creating a thread, so
+/// stacks of finished threads are kept and handed out again.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_STACKPOOL__HH
+#define NACHOS_THREADS_STACKPOOL__HH
+
+
+/// The following class defines a pool of thread stacks, all of the same
+/// size.
+class StackPool {
+public:
+
+    /// Initialize an empty pool of stacks of at least `stackSize` bytes,
+    /// and arrange for overflows into a guard page to be reported.
+    StackPool(unsigned stackSize);
+
+    /// Give every stack back to the host.  None may be in use.
+    ~StackPool();
+
+    /// Return a stack, taken from the pool if there is one, or mapped
+    /// otherwise.  The lowest address is returned; stacks grow down from
+    /// `GetStackSize()` bytes above it.
+    char *Allocate();
+
+    /// Put a stack returned by `Allocate` back into the pool.
+    void Free(char *stack);
+
+    /// Size of the stacks, in bytes, rounded up to whole host pages.
+    unsigned GetStackSize() const
+    {
+        return stackSize;
+    }
+
+    /// Return true if a fault at `addr` means that a stack overflowed: if it
+    /// is in the guard page of some stack, or not far below it, since a
+    /// large frame may skip over the guard page entirely.
+    bool IsOverflow(const void *addr) const;
+
+private:
+
+    unsigned stackSize;
+    unsigned pageSize;
+
+    /// Stacks not in use, linked through their first word.
+    char *freeStacks;
+
+    /// Every stack mapped so far, to recognize overflows.
+    char   **stacks;
+    unsigned numStacks;
+    unsigned maxStacks;
+
+};
+
+
+#endif
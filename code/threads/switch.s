@@ -125,17 +125,21 @@ SWITCH:
 /// * `rbx` -- contains initial argument to thread function [`InitialArg`].
 /// * `rsi` -- points to thread function [`InitialPC`].
 /// * `rdi` -- points to `Thread::Finish` [`WhenDonePCState`].
+///
+/// The stack is 16-byte aligned on entry, and must stay so at every call,
+/// as the ABI requires; so the functions are kept on it, rather than popped.
         .globl  ThreadRoot
 ThreadRoot:
         push   %rbp
         mov    %rsp,%rbp
         push   %rdi
         push   %rsi
+        sub    $8,%rsp
         callq  *%rax  // StartupPC()
         mov    %rbx,%rdi
-        pop    %rsi
+        mov    8(%rsp),%rsi
         callq  *%rsi  // InitialPC(InitialArg)
-        pop    %rsi
+        mov    16(%rsp),%rsi
         callq  *%rsi  // WhenDonePC()
 
         // NOT REACHED.
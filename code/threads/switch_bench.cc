@@ -0,0 +1,100 @@
+/// Benchmark of context switches between threads.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef SWITCH_BENCH
+
+#include "thread_test.hh"
+#include "synch.hh"
+#include "system.hh"
+
+#include <new>
+
+
+/// Number of round trips of each ping-pong.
+static const unsigned BENCH_ROUNDS = 200000;
+
+/// Heap allocations done so far, counted by the `operator new` below.
+static unsigned long allocations;
+
+void *
+operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size != 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void
+operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+static Semaphore *ping, *pong;
+
+static void
+Ponger(void *arg)
+{
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        ping->P();
+        pong->V();
+    }
+}
+
+static void
+Yielder(void *arg)
+{
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+        currentThread->Yield();
+}
+
+/// Report how long `BENCH_ROUNDS` round trips took on `clock`, and how many
+/// heap allocations they did.
+static void
+ReportRounds(const char *what, const BenchClock *clock,
+             unsigned long allocationsBefore)
+{
+    clock->Report(what, BENCH_ROUNDS, "round trips");
+    printf("%s: %lu heap allocations\n", what,
+           allocations - allocationsBefore);
+}
+
+/// Measure context switches between two threads, by semaphore ping-pong and
+/// by yielding to each other, counting the heap allocations done meanwhile.
+void
+SwitchBench()
+{
+    BenchClock    clock;
+    unsigned long before;
+
+    ping = new Semaphore("ping", 0);
+    pong = new Semaphore("pong", 0);
+    Thread *t = new Thread("ponger", false, 0);
+    t->Fork(Ponger, NULL);
+
+    before = allocations;
+    clock.Restart();
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        ping->V();
+        pong->P();
+    }
+    ReportRounds("Semaphore ping-pong", &clock, before);
+
+    t = new Thread("yielder", false, currentThread->GetPriority());
+    t->Fork(Yielder, NULL);
+    currentThread->Yield();  // Let it start, allocations and all.
+
+    before = allocations;
+    clock.Restart();
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++)
+        currentThread->Yield();
+    ReportRounds("Yield ping-pong", &clock, before);
+}
+
+#endif
@@ -32,9 +32,10 @@
 /// * `initialValue` is the initial value of the semaphore.
 Semaphore::Semaphore(const char *debugName, int initialValue)
 {
-    name  = debugName;
-    value = initialValue;
-    queue = new List<Thread *>;
+    name   = debugName;
+    value  = initialValue;
+    counts = synchProfile != NULL ? synchProfile->Find("semaphore", debugName)
+                                  : NULL;
 }
 
 /// De-allocate semaphore, when no longer needed.
@@ -42,7 +43,6 @@ Semaphore::Semaphore(const char *debugName, int initialValue)
 /// Assume no one is still waiting on the semaphore!
 Semaphore::~Semaphore()
 {
-    delete queue;
 }
 
 /// Wait until semaphore `value > 0`, then decrement.
@@ -57,13 +57,22 @@ Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
       // Disable interrupts.
+    unsigned long long waitStart = stats->totalTicks;
+    bool waited = false;
 
     while (value == 0) {  // Semaphore not available.
-        queue->Append(currentThread);  // So go to sleep.
+        queue.Append(currentThread);  // So go to sleep.
         currentThread->Sleep();
+        waited = true;
     }
     value--;  // Semaphore available, consume its value.
 
+    if (counts != NULL) {
+        counts->acquisitions++;
+        if (waited)
+            counts->CountWait(stats->totalTicks - waitStart);
+    }
+
     interrupt->SetLevel(oldLevel);  // Re-enable interrupts.
 }
 
@@ -78,108 +87,496 @@ Semaphore::V()
     Thread   *thread;
     IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
 
-    thread = queue->Remove();
+    thread = queue.Remove();
     if (thread != NULL)  // Make thread ready, consuming the `V` immediately.
         scheduler->ReadyToRun(thread);
     value++;
     interrupt->SetLevel(oldLevel);
 }
 
-/// Dummy functions -- so we can compile our later assignments.
-///
-/// Note -- without a correct implementation of `Condition::Wait`, the test
-/// case in the network assignment will not work!
-
 Lock::Lock(const char *debugName)
 {
-    Semaphore *sem_ = new Semaphore(name, 1);
-    name = debugName;
-    sem = sem_;
+    name     = debugName;
+    owner    = 0;
+    nextHeld = NULL;
+    counts   = synchProfile != NULL ? synchProfile->Find("lock", debugName)
+                                    : NULL;
+    acquiredAt = 0;
 }
 
 Lock::~Lock()
 {
-    delete sem;
+    ASSERT(owner == 0 && waiters.IsEmpty());
 }
 
+/// Take the lock at once if it is free; otherwise, wait for it.
+///
+/// Nothing can interrupt an atomic instruction, not even the preemption of
+/// `-p`, so there is no need to disable interrupts to take a free lock.
 void
 Lock::Acquire()
 {
     ASSERT(!(IsHeldByCurrentThread()));
-    if(lockThread != NULL  && currentThread->GetPriority() > lockThread->GetPriority()){
-        lockThread->ModifyPriority(currentThread->GetPriority());
-        scheduler->ChangePriority(lockThread);
+
+    if (__sync_bool_compare_and_swap(&owner, 0, (uintptr_t) currentThread)) {
+        nextHeld = currentThread->heldLocks;
+        currentThread->heldLocks = this;
+        if (counts != NULL) {
+            counts->acquisitions++;
+            acquiredAt = stats->totalTicks;
+        }
+    } else
+        AcquireContended();
+}
+
+/// Wait until the lock is free, lending our priority to the threads in the
+/// way meanwhile, and take it.
+void
+Lock::AcquireContended()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    unsigned long long waitStart = stats->totalTicks;
+    bool waited = owner != 0;
+
+    if (waited) {
+        owner |= CONTENDED;
+        currentThread->waitingFor = this;
+        Donate(currentThread->GetPriority());
+        waiters.Append(currentThread);
+        currentThread->Sleep();  // `Release` hands the lock over to us.
+        ASSERT(Holder() == currentThread);
+    } else {  // It was released since we tried.
+        owner    = (uintptr_t) currentThread;
+        nextHeld = currentThread->heldLocks;
+        currentThread->heldLocks = this;
+    }
+
+    if (counts != NULL) {
+        counts->acquisitions++;
+        if (waited)
+            counts->CountWait(stats->totalTicks - waitStart);
+        acquiredAt = stats->totalTicks;
     }
-    sem->P();
-    lockThread = currentThread;
+
+    interrupt->SetLevel(oldLevel);
 }
 
+/// Free the lock at once if nobody waits for it; otherwise, hand it over.
+///
+/// Nobody lent us priority through this lock if nobody waits for it, so
+/// there is nothing to recompute either.
 void
-Lock::Release()
+Lock::Unlock(bool mayYield)
 {
     ASSERT(IsHeldByCurrentThread());
-    if (currentThread->GetPriority() > currentThread->GetRealPriority())
-        scheduler->RestorePriority(currentThread);
-    sem->V();
-    lockThread = NULL;
+
+    if (counts != NULL)
+        counts->CountHold(stats->totalTicks - acquiredAt);
+
+    // Unlink the lock from the ones we hold.
+    Lock **l = &currentThread->heldLocks;
+    while (*l != this)
+        l = &(*l)->nextHeld;
+    *l = nextHeld;
+
+    if (!__sync_bool_compare_and_swap(&owner, (uintptr_t) currentThread, 0))
+        ReleaseContended(mayYield);
+}
+
+/// Give the lock to the waiter with the highest priority, and return to the
+/// priority owed to the locks still held.
+///
+/// If the new holder has a higher priority than ours now is, let it run,
+/// unless told not to.
+void
+Lock::ReleaseContended(bool mayYield)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Thread *next = waiters.Peek();
+    ASSERT(next != NULL);
+    for (Thread *t = next; t != NULL; t = waiters.Next(t))
+        if (t->GetPriority() > next->GetPriority())
+            next = t;
+    waiters.FindAndRemove(next);
+    owner = (uintptr_t) next | (waiters.IsEmpty() ? 0 : CONTENDED);
+    next->waitingFor = NULL;
+    nextHeld = next->heldLocks;
+    next->heldLocks = this;
+    RecomputePriority(next);
+    scheduler->ReadyToRun(next);
+
+    RecomputePriority(currentThread);
+    if (mayYield && next->GetPriority() > currentThread->GetPriority())
+        currentThread->Yield();
+
+    interrupt->SetLevel(oldLevel);
 }
 
 bool
 Lock::IsHeldByCurrentThread()
 {
-    return currentThread == lockThread;
+    return currentThread == Holder();
 }
 
-Condition::Condition(const char *debugName, Lock *conditionLock)
+/// Each holder along the chain is raised, and moved to its new ready list
+/// if it is ready; the walk stops at a holder that already runs with at
+/// least `priority`, since the ones after it do as well.
+void
+Lock::Donate(int priority)
 {
-    name = debugName;
-    internalLock = new Lock (name);
-    internalSem = new Semaphore (name, 0);
-    externalLock = conditionLock;
-    waiters = 0;
+    for (Lock *l = this; l != NULL; l = l->Holder()->waitingFor) {
+        Thread *holder = l->Holder();
+        ASSERT(holder != NULL);
+        if (holder->GetPriority() >= priority)
+            break;
+        DEBUG('s', "Thread \"%s\" inherits priority %d through lock "
+              "\"%s\"\n", holder->getName(), priority, l->GetName());
+        holder->ModifyPriority(priority);
+        scheduler->ChangePriority(holder);
+    }
 }
 
-Condition::~Condition()
+int
+Lock::WaitersPriority()
 {
-    delete internalLock;
-    delete internalSem;
+    int priority = -1;
+
+    for (Thread *t = waiters.Peek(); t != NULL; t = waiters.Next(t))
+        if (t->GetPriority() > priority)
+            priority = t->GetPriority();
+    return priority;
 }
 
+void
+Lock::RecomputePriority(Thread *thread)
+{
+    int priority = thread->GetRealPriority();
 
+    for (Lock *l = thread->heldLocks; l != NULL; l = l->nextHeld) {
+        int inherited = l->WaitersPriority();
+        if (inherited > priority)
+            priority = inherited;
+    }
+    for (unsigned i = 0; i < thread->numHeldRWLocks; i++) {
+        int inherited = thread->heldRWLocks[i]->WaitersPriority();
+        if (inherited > priority)
+            priority = inherited;
+    }
+    if (priority != thread->GetPriority()) {
+        thread->ModifyPriority(priority);
+        scheduler->ChangePriority(thread);
+    }
+}
+
+RWLock::RWLock(const char *debugName)
+{
+    name       = debugName;
+    writer     = NULL;
+    readers    = NULL;
+    numReaders = 0;
+    maxReaders = 0;
+}
+
+RWLock::~RWLock()
+{
+    ASSERT(writer == NULL && numReaders == 0);
+    ASSERT(readWaiters.IsEmpty() && writeWaiters.IsEmpty());
+    delete [] readers;
+}
+
+/// Readers wait if a writer holds the lock or is waiting for it.
+void
+RWLock::AcquireRead()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (writer == NULL && writeWaiters.IsEmpty())
+        Hold(currentThread, true);
+    else
+        Block(&readWaiters);
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+RWLock::AcquireWrite()
+{
+    ASSERT(writer != currentThread);
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (writer == NULL && numReaders == 0)
+        Hold(currentThread, false);
+    else
+        Block(&writeWaiters);
+
+    interrupt->SetLevel(oldLevel);
+}
+
+/// The last reader to leave hands the lock over.
+void
+RWLock::ReleaseRead()
+{
+    ASSERT(writer != currentThread);
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Unhold(currentThread);
+    int woken = numReaders == 0 ? HandOver() : -1;
+    Lock::RecomputePriority(currentThread);
+    if (woken > currentThread->GetPriority())
+        currentThread->Yield();
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+RWLock::ReleaseWrite()
+{
+    ASSERT(writer == currentThread);
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Unhold(currentThread);
+    int woken = HandOver();
+    Lock::RecomputePriority(currentThread);
+    if (woken > currentThread->GetPriority())
+        currentThread->Yield();
+
+    interrupt->SetLevel(oldLevel);
+}
+
+int
+RWLock::WaitersPriority()
+{
+    int priority = -1;
+
+    for (Thread *t = readWaiters.Peek(); t != NULL; t = readWaiters.Next(t))
+        if (t->GetPriority() > priority)
+            priority = t->GetPriority();
+    for (Thread *t = writeWaiters.Peek(); t != NULL; t = writeWaiters.Next(t))
+        if (t->GetPriority() > priority)
+            priority = t->GetPriority();
+    return priority;
+}
+
+/// Raise each holder that runs with less than `priority`, and go on along
+/// the chain of locks it waits for.
+void
+RWLock::Donate(int priority)
+{
+    for (unsigned i = 0; i <= numReaders; i++) {
+        Thread *holder = i < numReaders ? readers[i] : writer;
+        if (holder == NULL || holder->GetPriority() >= priority)
+            continue;
+        DEBUG('s', "Thread \"%s\" inherits priority %d through "
+              "reader-writer lock \"%s\"\n", holder->getName(), priority,
+              GetName());
+        holder->ModifyPriority(priority);
+        scheduler->ChangePriority(holder);
+        if (holder->waitingFor != NULL)
+            holder->waitingFor->Donate(priority);
+    }
+}
+
+void
+RWLock::Block(IntrusiveList<Thread, &Thread::queueLink> *queue)
+{
+    Donate(currentThread->GetPriority());
+    queue->Append(currentThread);
+    currentThread->Sleep();
+}
+
+/// Returns the highest priority among the threads woken up, or -1 if there
+/// were none.
+int
+RWLock::HandOver()
+{
+    ASSERT(writer == NULL && numReaders == 0);
+
+    Thread *next = writeWaiters.Peek();
+    if (next != NULL) {
+        for (Thread *t = next; t != NULL; t = writeWaiters.Next(t))
+            if (t->GetPriority() > next->GetPriority())
+                next = t;
+        writeWaiters.FindAndRemove(next);
+        Hold(next, false);
+        Lock::RecomputePriority(next);
+        scheduler->ReadyToRun(next);
+        return next->GetPriority();
+    }
+
+    int woken = -1;
+    while ((next = readWaiters.Remove()) != NULL) {
+        Hold(next, true);
+        scheduler->ReadyToRun(next);
+        if (next->GetPriority() > woken)
+            woken = next->GetPriority();
+    }
+    return woken;
+}
+
+void
+RWLock::Hold(Thread *thread, bool reading)
+{
+    ASSERT(thread->numHeldRWLocks < MAX_HELD_RWLOCKS);
+    thread->heldRWLocks[thread->numHeldRWLocks++] = this;
+
+    if (!reading) {
+        writer = thread;
+        return;
+    }
+    if (numReaders == maxReaders) {
+        maxReaders = maxReaders == 0 ? 4 : 2 * maxReaders;
+        Thread **bigger = new Thread *[maxReaders];
+        if (numReaders > 0)
+            memcpy(bigger, readers, numReaders * sizeof *readers);
+        delete [] readers;
+        readers = bigger;
+    }
+    readers[numReaders++] = thread;
+}
+
+void
+RWLock::Unhold(Thread *thread)
+{
+    unsigned i;
+    for (i = 0; i < thread->numHeldRWLocks && thread->heldRWLocks[i] != this;
+         i++)
+        ;
+    ASSERT(i < thread->numHeldRWLocks);  // The lock must be held.
+    thread->heldRWLocks[i] = thread->heldRWLocks[--thread->numHeldRWLocks];
+
+    if (thread == writer) {
+        writer = NULL;
+        return;
+    }
+    for (i = 0; i < numReaders && readers[i] != thread; i++)
+        ;
+    ASSERT(i < numReaders);
+    readers[i] = readers[--numReaders];
+}
+
+Condition::Condition(const char *debugName, Lock *lock)
+{
+    name          = debugName;
+    conditionLock = lock;
+    counts        = synchProfile != NULL
+                      ? synchProfile->Find("condition", debugName) : NULL;
+}
+
+Condition::~Condition()
+{
+    ASSERT(queue.IsEmpty());
+}
+
+/// Release the lock and go to sleep, atomically, then take the lock again.
+///
+/// The lock is released without yielding, since we are about to give up
+/// the CPU anyway, and a thread that ran before we are queued could signal
+/// us in vain.
 void
 Condition::Wait()
 {
-    ASSERT(externalLock -> IsHeldByCurrentThread());
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    unsigned long long waitStart = stats->totalTicks;
+    conditionLock->Unlock(false);
+    queue.Append(currentThread);
+    currentThread->Sleep();
+    if (counts != NULL) {
+        counts->acquisitions++;
+        counts->CountWait(stats->totalTicks - waitStart);
+    }
+
+    interrupt->SetLevel(oldLevel);
+    conditionLock->Acquire();
+}
+
+/// The `TimedWait` is shared with the `Timeout` interrupt, and whichever of
+/// the two is done with it last frees it: the interrupt cannot be called
+/// off.
+bool
+Condition::WaitFor(unsigned ticks)
+{
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+    ASSERT(ticks > 0);
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
 
-    internalLock -> Acquire();
-    waiters ++;
-    internalLock -> Release();
-    
-    externalLock -> Release();
-    internalSem -> P();
-    externalLock -> Acquire();
+    TimedWait *timedWait = new TimedWait;
+    timedWait->condition = this;
+    timedWait->thread    = currentThread;
+    timedWait->fired     = false;
+    timedWait->timedOut  = false;
+    timedWait->orphaned  = false;
+    interrupt->Schedule(Timeout, timedWait, ticks, TIMEOUT_INT);
+
+    unsigned long long waitStart = stats->totalTicks;
+    conditionLock->Unlock(false);
+    queue.Append(currentThread);
+    currentThread->Sleep();
+    if (counts != NULL) {
+        counts->acquisitions++;
+        counts->CountWait(stats->totalTicks - waitStart);
+    }
+
+    bool signaled = !timedWait->timedOut;
+    if (timedWait->fired)
+        delete timedWait;
+    else
+        timedWait->orphaned = true;
+
+    interrupt->SetLevel(oldLevel);
+    conditionLock->Acquire();
+    return signaled;
 }
 
+/// Wake up the thread of a `WaitFor`, unless it was signaled already.
+void
+Condition::Timeout(void *arg)
+{
+    TimedWait *timedWait = (TimedWait *) arg;
+
+    if (timedWait->orphaned) {
+        delete timedWait;
+        return;
+    }
+    timedWait->fired = true;
+    if (timedWait->condition->queue.Contains(timedWait->thread)) {
+        timedWait->condition->queue.FindAndRemove(timedWait->thread);
+        timedWait->timedOut = true;
+        scheduler->ReadyToRun(timedWait->thread);
+    }
+}
+
+/// Nothing is done if nobody waits.  Threads are only queued by holders of
+/// the lock, so none can be missed; one can still time out meanwhile.
 void
 Condition::Signal()
 {
-    internalLock -> Acquire();
-        if (waiters > 0){
-            waiters--;
-            internalSem -> V();
-        }
-    internalLock -> Release();
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+    if (queue.IsEmpty())
+        return;
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Thread *thread = queue.Remove();
+    if (thread != NULL)
+        scheduler->ReadyToRun(thread);
+
+    interrupt->SetLevel(oldLevel);
 }
 
 void
 Condition::Broadcast()
 {
-    internalLock -> Acquire();
-        while (waiters > 0){
-            waiters--;
-            internalSem -> V();
-        }
-    internalLock -> Release();
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+    if (queue.IsEmpty())
+        return;
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    for (Thread *thread; (thread = queue.Remove()) != NULL;)
+        scheduler->ReadyToRun(thread);
+
+    interrupt->SetLevel(oldLevel);
 }
 
 Port::Port(const char * debugName)
@@ -21,8 +21,11 @@
 
 
 #include "list.hh"
+#include "synch_profile.hh"
 #include "thread.hh"
 
+#include <stdint.h>
+
 
 /// This class defines a “semaphore”, which has a positive integer as its
 /// value.
@@ -67,7 +70,10 @@ private:
     int value;
 
     /// Queue of threads waiting on `P` because the value is zero.
-    List<Thread *> *queue;
+    IntrusiveList<Thread, &Thread::queueLink> queue;
+
+    /// Contention counts, `NULL` unless profiling (see `synch_profile.hh`).
+    SynchCounts *counts;
 
 };
 
@@ -82,6 +88,18 @@ private:
 ///
 /// For convenience, nobody but the thread that holds the lock can free it.
 /// There is no operation for reading the state of the lock.
+///
+/// Locks implement priority inheritance: the holder of a lock runs with at
+/// least the priority of the threads waiting for it, and so does the holder
+/// of any lock that holder is itself waiting for, along the whole chain.
+/// When a lock is released, it is handed to the waiter with the highest
+/// priority, and the priority of the releasing thread is recomputed from
+/// the locks it still holds.
+///
+/// Taking a free lock, or releasing one nobody waits for, is done with a
+/// single atomic instruction, without disabling interrupts; re-enabling
+/// them would cost simulated time and a check for pending interrupts.
+/// Interrupts are only disabled to block or to hand the lock over.
 class Lock {
 public:
 
@@ -100,7 +118,10 @@ public:
     ///
     /// Both must be *atomic*.
     void Acquire();
-    void Release();
+    void Release()
+    {
+        Unlock(true);
+    }
 
     /// Returns `true` if the current thread is the one that possesses the
     /// lock.
@@ -108,13 +129,136 @@ public:
     /// Useful for checks in `Release` and in condition variables.
     bool IsHeldByCurrentThread();
 
+    /// Set the priority of `thread` to the highest of its own and those of
+    /// the waiters of the locks it holds, reader-writer locks included.
+    ///
+    /// Also used by the scheduler, whenever it changes the priority of a
+    /// thread on its own.
+    static void RecomputePriority(Thread *thread);
+
 private:
 
+    /// Condition variables release the lock of a waiter before putting it
+    /// to sleep.
+    friend class Condition;
+
+    /// Reader-writer locks lend priority along chains of locks too.
+    friend class RWLock;
+
+    /// Free the lock, handing it to a waiter if there is one.  If
+    /// `mayYield`, let the new holder run right away if it has a higher
+    /// priority than ours.
+    void Unlock(bool mayYield);
+
+    /// Raise the priority of the holder to `priority`, and go on along the
+    /// chain of locks that holders are waiting for.
+    void Donate(int priority);
+
+    /// Highest priority among the waiters, or -1 if there are none.
+    int WaitersPriority();
+
+    /// The part of `Acquire` and `Unlock` done with interrupts disabled.
+    void AcquireContended();
+    void ReleaseContended(bool mayYield);
+
+    /// The thread that holds the lock, or `NULL` if it is free.
+    Thread *Holder() const
+    {
+        return (Thread *) (owner & ~CONTENDED);
+    }
+
+    /// Bit of `owner` set while there are threads waiting for the lock.
+    static const uintptr_t CONTENDED = 1;
+
     /// For debugging.
     const char* name;
-    Semaphore *sem;
-    Thread *lockThread;
-    // Add other needed fields here.
+
+    /// The thread that holds the lock, or 0 if it is free, plus the
+    /// `CONTENDED` bit.  An uncontended `Release` only succeeds in clearing
+    /// it if the bit is not set, so that it cannot miss a waiter that came
+    /// in the meantime.
+    volatile uintptr_t owner;
+
+    /// Threads waiting for the lock.
+    IntrusiveList<Thread, &Thread::queueLink> waiters;
+
+    /// Next lock held by the holder, in `Thread::heldLocks`.
+    Lock *nextHeld;
+
+    /// Contention counts, `NULL` unless profiling, and when the holder took
+    /// the lock.
+    SynchCounts *counts;
+    unsigned long long acquiredAt;
+};
+
+/// This class defines a “reader-writer lock”.
+///
+/// Any number of threads can hold it for reading at the same time, or a
+/// single one for writing.  It prefers writers: once a writer waits, new
+/// readers wait behind it, so that a steady stream of readers cannot starve
+/// writers.
+///
+/// Like locks, reader-writer locks implement priority inheritance: the
+/// writer or every reader holding it runs with at least the priority of the
+/// threads waiting for it.  Lending goes on along a chain of `Lock`s the
+/// holders wait for, but not through other reader-writer locks.
+///
+/// When released, the lock is handed over to the waiting writer with the
+/// highest priority, or, if there is none, to every waiting reader.
+class RWLock {
+public:
+
+    RWLock(const char *debugName);
+
+    ~RWLock();
+
+    const char *GetName()
+    {
+        return name;
+    }
+
+    /// Operations on the lock, for reading and for writing.
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+
+    /// Highest priority among the waiters, or -1 if there are none.
+    ///
+    /// Used by `Lock::RecomputePriority`, for the reader-writer locks a
+    /// thread holds.
+    int WaitersPriority();
+
+private:
+
+    /// Raise the holders to `priority`.
+    void Donate(int priority);
+
+    /// Wait until `Release` hands the lock over to us.
+    void Block(IntrusiveList<Thread, &Thread::queueLink> *queue);
+
+    /// Hand the lock over to the waiters that should take it next, if any,
+    /// once nobody holds it.
+    int HandOver();
+
+    /// Record `thread` as a holder, for reading or writing, or forget it.
+    void Hold(Thread *thread, bool reading);
+    void Unhold(Thread *thread);
+
+    const char *name;
+
+    /// The thread holding the lock for writing, if any.
+    Thread *writer;
+
+    /// The threads holding the lock for reading.
+    Thread  **readers;
+    unsigned  numReaders;
+    unsigned  maxReaders;
+
+    /// Threads waiting to read and to write.
+    IntrusiveList<Thread, &Thread::queueLink> readWaiters;
+    IntrusiveList<Thread, &Thread::queueLink> writeWaiters;
+
 };
 
 // This class defined a “condition variable”.
@@ -149,6 +293,9 @@ private:
 // The “Mesa” style is somewhat simpler to implement, but it does not
 // guarantee that the woken thread recover the control of the lock
 // immediately.
+//
+// Waiting threads are kept in a queue of the condition itself, and
+// `Signal` and `Broadcast` move them straight to the ready queue.
 class Condition {
 public:
 
@@ -171,15 +318,37 @@ public:
     void Signal();
     void Broadcast();
 
+    /// Like `Wait`, but give up waiting after `ticks` of simulated time.
+    ///
+    /// Returns `false` if the time ran out before a `Signal` or
+    /// `Broadcast` woke the thread up.  Either way, the lock is held again
+    /// on return.
+    bool WaitFor(unsigned ticks);
+
 private:
 
+    /// A `WaitFor` in progress, shared with the interrupt that ends it.
+    struct TimedWait {
+        Condition *condition;
+        Thread    *thread;
+        bool       fired;     ///< The interrupt has happened.
+        bool       timedOut;  ///< It woke the thread up.
+        bool       orphaned;  ///< The thread no longer waits for it.
+    };
+
+    /// Interrupt handler that ends a `WaitFor`.
+    static void Timeout(void *timedWait);
+
     const char *name;
-    
-    // Other needed fields are to be added here.
-    Lock *externalLock;
-    Lock *internalLock;
-    Semaphore *internalSem;
-    int waiters;
+
+    /// The lock the condition variable belongs to.
+    Lock *conditionLock;
+
+    /// Threads waiting on the condition.
+    IntrusiveList<Thread, &Thread::queueLink> queue;
+
+    /// Contention counts, `NULL` unless profiling.
+    SynchCounts *counts;
 
 };
 
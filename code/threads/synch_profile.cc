@@ -0,0 +1,102 @@
+/// Routines to profile contention on synchronization objects.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "synch_profile.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+SynchProfile::SynchProfile()
+{
+    memset(buckets, 0, sizeof buckets);
+    numCounts = 0;
+}
+
+SynchProfile::~SynchProfile()
+{
+    for (unsigned i = 0; i < SYNCH_PROFILE_BUCKETS; i++)
+        while (buckets[i] != NULL) {
+            SynchCounts *c = buckets[i];
+            buckets[i] = c->next;
+            delete [] c->name;
+            delete c;
+        }
+}
+
+/// Objects are looked up once, when they are created, so a chained table
+/// is plenty.  Names are copied, since they may not outlive the object.
+SynchCounts *
+SynchProfile::Find(const char *kind, const char *name)
+{
+    unsigned hash = 0;
+
+    if (name == NULL)
+        name = "?";
+    for (const char *s = name; *s != '\0'; s++)
+        hash = hash * 31 + (unsigned char) *s;
+
+    SynchCounts **bucket = &buckets[hash % SYNCH_PROFILE_BUCKETS];
+    for (SynchCounts *c = *bucket; c != NULL; c = c->next)
+        if (strcmp(c->kind, kind) == 0 && strcmp(c->name, name) == 0)
+            return c;
+
+    SynchCounts *c = new SynchCounts;
+    memset(c, 0, sizeof *c);
+    c->kind = kind;
+    c->name = new char[strlen(name) + 1];
+    strcpy(c->name, name);
+    c->next = *bucket;
+    *bucket = c;
+    numCounts++;
+    return c;
+}
+
+/// Order counts by ticks waited, then by contended acquisitions, the
+/// largest first, for `qsort`.
+int
+SynchProfile::CompareCounts(const void *a, const void *b)
+{
+    const SynchCounts *x = *(const SynchCounts * const *) a;
+    const SynchCounts *y = *(const SynchCounts * const *) b;
+
+    if (x->waitTicks != y->waitTicks)
+        return x->waitTicks < y->waitTicks ? 1 : -1;
+    if (x->contended != y->contended)
+        return x->contended < y->contended ? 1 : -1;
+    return 0;
+}
+
+/// Objects that were never taken are left out.
+void
+SynchProfile::Print()
+{
+    SynchCounts **sorted = new SynchCounts *[numCounts + 1];
+    unsigned      n      = 0;
+
+    for (unsigned i = 0; i < SYNCH_PROFILE_BUCKETS; i++)
+        for (SynchCounts *c = buckets[i]; c != NULL; c = c->next)
+            if (c->acquisitions > 0)
+                sorted[n++] = c;
+    qsort(sorted, n, sizeof *sorted, CompareCounts);
+
+    printf("\nSynchronization profile: %u objects used\n", n);
+    if (n > 0)
+        printf("%12s %10s %6s %12s %8s %12s %8s  %s\n", "acquisitions",
+               "contended", "%", "wait ticks", "max", "hold ticks", "max",
+               "object");
+    for (unsigned i = 0; i < n; i++) {
+        const SynchCounts *c = sorted[i];
+        printf("%12llu %10llu %6.2f %12llu %8llu %12llu %8llu  %s %s\n",
+               c->acquisitions, c->contended,
+               100.0 * c->contended / c->acquisitions, c->waitTicks,
+               c->maxWait, c->holdTicks, c->maxHold, c->kind, c->name);
+    }
+
+    delete [] sorted;
+}
@@ -0,0 +1,81 @@
+/// Data structures for profiling contention on synchronization objects.
+///
+/// When the `k` debugging flag is on, every semaphore, lock and condition
+/// variable counts how many times it was taken, how many of those the
+/// thread had to wait, and for how long, in simulated ticks; locks also
+/// count for how long they were held.  Objects of the same kind and name
+/// share their counts, so that, for instance, the locks of every `Port`
+/// are reported together.  The report is printed at shutdown.
+///
+/// With the flag off, objects have no counts to update, and the only cost
+/// is checking for that.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_SYNCHPROFILE__HH
+#define NACHOS_THREADS_SYNCHPROFILE__HH
+
+
+/// Counts of the synchronization objects of a kind and name.
+struct SynchCounts {
+    const char *kind;
+    char       *name;
+
+    unsigned long long acquisitions;  ///< `P`, `Acquire` or `Wait`.
+    unsigned long long contended;     ///< Acquisitions that had to wait.
+    unsigned long long waitTicks;
+    unsigned long long maxWait;
+    unsigned long long holdTicks;     ///< Only for locks.
+    unsigned long long maxHold;
+
+    SynchCounts *next;  ///< Next counts in the same bucket.
+
+    void CountWait(unsigned long long ticks)
+    {
+        contended++;
+        waitTicks += ticks;
+        if (ticks > maxWait)
+            maxWait = ticks;
+    }
+
+    void CountHold(unsigned long long ticks)
+    {
+        holdTicks += ticks;
+        if (ticks > maxHold)
+            maxHold = ticks;
+    }
+};
+
+/// Number of buckets of the table of counts, by name.
+const unsigned SYNCH_PROFILE_BUCKETS = 64;
+
+class SynchProfile {
+public:
+
+    /// Initialize a profile with no counts.
+    SynchProfile();
+
+    /// De-allocate the counts.
+    ~SynchProfile();
+
+    /// Return the counts of objects of `kind` named `name`, which start at
+    /// zero the first time.  `kind` must be a constant string, that is not
+    /// copied.
+    SynchCounts *Find(const char *kind, const char *name);
+
+    /// Print the report, the most contended objects first.
+    void Print();
+
+private:
+
+    static int CompareCounts(const void *a, const void *b);
+
+    SynchCounts *buckets[SYNCH_PROFILE_BUCKETS];
+    unsigned numCounts;
+
+};
+
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "system.hh"
 #include "preemptive.hh"
+#include "slab.hh"
 
 
 /// This defines *all* of the global data structures used by Nachos.
@@ -21,10 +22,13 @@ Interrupt *interrupt;         ///< Interrupt status.
 Statistics *stats;            ///< Performance metrics.
 Timer *timer;                 ///< The hardware timer device, for invoking
                               ///< context switches.
+StackPool *stackPool;         ///< Stacks for forked threads.
+AlarmClock *alarmClock;       ///< Sleeping threads.
+SynchProfile *synchProfile;   ///< Contention counts, if profiling.
 
 // 2007, Jose Miguel Santos Espino
 PreemptiveScheduler *preemptiveScheduler = NULL;
-const long long DEFAULT_TIME_SLICE = 50000;
+const long long DEFAULT_TIME_SLICE = 10000;  // Microseconds.
 
 #ifdef FILESYS_NEEDED
 FileSystem *fileSystem;
@@ -38,6 +42,7 @@ SynchDisk *synchDisk;
 //#include "userprog/synchConsole.cc"
 //#include "userprogtable.cc"
 Machine *machine;  ///< User program memory and registers.
+BitMap *frameMap;  ///< Physical pages in use.
 ProcessTable *processTable;
 SynchConsole *console;
 #endif
@@ -66,8 +71,10 @@ extern void Cleanup();
 static void
 TimerInterruptHandler(void *dummy)
 {
-    if (interrupt->getStatus() != IDLE_MODE)
+    if (interrupt->getStatus() != IDLE_MODE) {
+        scheduler->TimerTick();
         interrupt->YieldOnReturn();
+    }
 }
 
 /// Initialize Nachos global data structures.
@@ -88,6 +95,8 @@ Initialize(int argc, char **argv)
     int argCount;
     const char *debugArgs = "";
     bool randomYield = false;
+    SchedulingPolicy policy = STATIC_PRIORITIES;
+    unsigned stackSize = STACK_SIZE;  // Words of each thread stack.
 
     // 2007, Jose Miguel Santos Espino
     bool preemptiveScheduling = false;
@@ -95,6 +104,10 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
+    bool translateUserProg = false;  // Translate user program to host code.
+    bool profileUserProg = false;  // Count instructions run by user programs.
+    unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES;
+    unsigned tlbSize = DEFAULT_TLB_SIZE;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = false;  // Format disk.
@@ -119,6 +132,13 @@ Initialize(int argc, char **argv)
                                             // number generator.
             randomYield = true;
             argCount = 2;
+        } else if (!strcmp(*argv, "-mlfq"))
+            policy = MULTILEVEL_FEEDBACK;
+        else if (!strcmp(*argv, "-ss")) {
+            ASSERT(argc > 1);
+            stackSize = atoi(*(argv + 1));
+            ASSERT(stackSize > 0);
+            argCount = 2;
         }
         // 2007, Jose Miguel Santos Espino
         else if (!strcmp(*argv, "-p")) {
@@ -133,6 +153,19 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s"))
             debugUserProg = true;
+        else if (!strcmp(*argv, "-j"))
+            translateUserProg = true;
+        else if (!strcmp(*argv, "-prof"))
+            profileUserProg = true;
+        else if (!strcmp(*argv, "-mp")) {
+            ASSERT(argc > 1);
+            numPhysPages = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tlb")) {
+            ASSERT(argc > 1);
+            tlbSize = atoi(*(argv + 1));
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f"))
@@ -152,12 +185,17 @@ Initialize(int argc, char **argv)
     }
 
     DebugInit(debugArgs);         // Initialize `DEBUG` messages.
+    if (DebugIsEnabled('k'))
+        synchProfile = new SynchProfile;  // Before anything synchronizes.
     stats = new Statistics();     // Collect statistics.
     interrupt = new Interrupt;    // Start up interrupt handling.
-    scheduler = new Scheduler();  // Initialize the ready queue.
-    if (randomYield)              // Start the timer (if needed).
+    scheduler = new Scheduler(policy);  // Initialize the ready queue.
+    if (randomYield || policy == MULTILEVEL_FEEDBACK)
+        // Start the timer (if needed).
         timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
+    stackPool = new StackPool(stackSize * sizeof (HostMemoryAddress));
+    alarmClock = new AlarmClock;
     threadToBeDestroyed = NULL;
 
     // We did not explicitly allocate the current thread we are running in.
@@ -176,7 +214,12 @@ Initialize(int argc, char **argv)
     }
 
 #ifdef USER_PROGRAM
-    machine = new Machine(debugUserProg);  // This must come first.
+    machine = new Machine(debugUserProg, translateUserProg,
+                          numPhysPages, tlbSize);
+      // This must come first.
+    if (profileUserProg)
+        machine->StartProfile();
+    frameMap = new BitMap(numPhysPages);
     processTable = new ProcessTable();
     console = new SynchConsole(NULL, NULL);
 #endif
@@ -200,6 +243,13 @@ Cleanup()
 {
     DEBUG('i', "\nCleaning up...\n");
 
+    // The profile is not de-allocated: objects deleted below may still
+    // count on it.
+    if (synchProfile != NULL)
+        synchProfile->Print();
+    if (DebugIsEnabled('h'))
+        SlabAllocator::PrintAll();
+
     // 2007, Jose Miguel Santos Espino
     delete preemptiveScheduler;
 
@@ -208,6 +258,7 @@ Cleanup()
 #endif
 
 #ifdef USER_PROGRAM
+    delete frameMap;
     delete machine;
 #endif
 
@@ -219,9 +270,13 @@ Cleanup()
     delete synchDisk;
 #endif
 
+    delete alarmClock;
     delete timer;
     delete scheduler;
     delete interrupt;
+    interrupt = NULL;  // Objects freed from now on find no interrupts.
+    // The stack pool is not de-allocated: we may be running on one of its
+    // stacks.
 
     Exit(0);
 }
@@ -12,6 +12,9 @@
 #include "utility.hh"
 #include "thread.hh"
 #include "scheduler.hh"
+#include "stack_pool.hh"
+#include "alarm_clock.hh"
+#include "synch_profile.hh"
 #include "machine/interrupt.hh"
 #include "machine/statistics.hh"
 #include "machine/timer.hh"
@@ -32,12 +35,17 @@ extern Scheduler *scheduler;         ///< The ready list.
 extern Interrupt *interrupt;         ///< Interrupt status.
 extern Statistics *stats;            ///< Performance metrics.
 extern Timer *timer;                 ///< The hardware alarm clock.
+extern StackPool *stackPool;         ///< Stacks for forked threads.
+extern AlarmClock *alarmClock;       ///< Sleeping threads.
+extern SynchProfile *synchProfile;   ///< Contention counts, if profiling.
 
 #ifdef USER_PROGRAM
 #include "machine/machine.hh"
 #include "userprogtable.hh"
 #include "userprog/synchConsole.hh"
+#include "userprog/bitmap.hh"
 extern Machine *machine;  // User program memory and registers.
+extern BitMap *frameMap;  // Physical pages in use.
 extern ProcessTable *processTable;
 extern SynchConsole *console;
 #endif
@@ -37,10 +37,20 @@ Thread::Thread(const char* threadName, bool flag, int prior)
     stackTop = NULL;
     stack    = NULL;
     status   = JUST_CREATED;
+    statusSince = stats != NULL ? stats->totalTicks : 0;
+    runTicks = readyTicks = blockedTicks = 0;
+    voluntarySwitches = involuntarySwitches = 0;
     joinFlag = flag;
     ASSERT(prior<10 && prior>=0);
     priority = prior;
     realPriority = prior;
+    basePriority = prior;
+    heldLocks  = NULL;
+    waitingFor = NULL;
+    numHeldRWLocks = 0;
+    wakeTime = 0;
+    quantumTicks = 0;
+    boostEpoch   = 0;
     if(joinFlag){
         port = new Port(name);
     }
@@ -65,7 +75,7 @@ Thread::~Thread()
 
     ASSERT(this != currentThread);
     if (stack != NULL)
-        DeallocBoundedArray((char *) stack, STACK_SIZE * sizeof *stack);
+        stackPool->Free((char *) stack);
 }
 
 /// Invoke `(*func)(arg)`, allowing caller and callee to execute
@@ -108,7 +118,9 @@ Thread::Fork(VoidFunctionPtr func, void* arg)
 /// worry about this, but we do not.
 ///
 /// NOTE: Nachos will not catch all stack overflow conditions.  In other
-/// words, your program may still crash because of an overflow.
+/// words, your program may still crash because of an overflow.  Most
+/// overflows run into the guard page below the stack, though, and are
+/// reported right away (see `stack_pool.hh`).
 ///
 /// If you get bizarre results (such as seg faults where there is no code)
 /// then you *may* need to increase the stack size.  You can avoid stack
@@ -150,6 +162,21 @@ Thread::GetRealPriority()
     return realPriority;
 }
 
+int
+Thread::GetBasePriority()
+{
+    return basePriority;
+}
+
+/// Change the priority the thread has when it inherits none.  The caller
+/// must recompute the inherited one.
+void
+Thread::SetRealPriority(int prior)
+{
+    ASSERT(prior<10 && prior>=0);
+    realPriority = prior;
+}
+
 void
 Thread::RestorePriority()
 {
@@ -179,7 +206,10 @@ Thread::Finish()
     interrupt->SetLevel(INT_OFF);
     ASSERT(this == currentThread);
 
-    DEBUG('t', "Finishing thread \"%s\"\n", getName());
+    DEBUG('t', "Finishing thread \"%s\": ran %llu ticks, ready %llu, "
+          "blocked %llu; switches: voluntary %u, involuntary %u\n",
+          getName(), runTicks, readyTicks, blockedTicks, voluntarySwitches,
+          involuntarySwitches);
     if(joinFlag){
         port -> Send(0);
     }
@@ -189,12 +219,46 @@ Thread::Finish()
     // Not reached.
 }
 
+/// Waits on the ready list also go to the histogram of ready-to-run
+/// latencies.
+void
+Thread::setStatus(ThreadStatus st, bool dispatched)
+{
+    if (status == READY && st == RUNNING && dispatched)
+        stats->CountReadyLatency(stats->totalTicks - statusSince);
+    UpdateTicks();
+    status = st;
+}
+
+/// Time before the thread is first made ready is not charged to anything.
+void
+Thread::UpdateTicks()
+{
+    unsigned long long elapsed = stats->totalTicks - statusSince;
+
+    switch (status) {
+        case RUNNING:
+            runTicks += elapsed;
+            break;
+        case READY:
+            readyTicks += elapsed;
+            break;
+        case BLOCKED:
+            blockedTicks += elapsed;
+            break;
+        default:
+            break;
+    }
+    statusSince = stats->totalTicks;
+}
+
 /// Relinquish the CPU if any other thread is ready to run.
 ///
 /// If so, put the thread on the end of the ready list, so that it will
-/// eventually be re-scheduled.
+/// eventually be re-scheduled.  Under the multilevel feedback queue, only
+/// threads of at least the same priority get the CPU this way.
 ///
-/// NOTE: returns immediately if no other thread on the ready queue.
+/// NOTE: returns immediately if no such thread on the ready queue.
 /// Otherwise returns when the thread eventually works its way to the front
 /// of the ready list and gets re-scheduled.
 ///
@@ -214,9 +278,24 @@ Thread::Yield()
 
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
 
-    nextThread = scheduler->FindNextToRun();
-    if (nextThread != NULL) {
+    if (scheduler->GetPolicy() == MULTILEVEL_FEEDBACK) {
+        // Put the thread back first, so that a time slice does not go to a
+        // thread of lower priority, which would make moving threads down
+        // pointless.
         scheduler->ReadyToRun(this);
+        nextThread = scheduler->FindNextToRun();
+        if (nextThread == this) {
+            setStatus(RUNNING, false);
+            nextThread = NULL;
+        }
+    } else {
+        nextThread = scheduler->FindNextToRun();
+        if (nextThread != NULL)
+            scheduler->ReadyToRun(this);
+    }
+    if (nextThread != NULL) {
+        involuntarySwitches++;  // Still ready to run.
+        stats->numInvoluntarySwitches++;
         scheduler->Run(nextThread);
     }
     interrupt->SetLevel(oldLevel);
@@ -246,14 +325,33 @@ Thread::Sleep()
 
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
-    status = BLOCKED;
+    setStatus(BLOCKED);
+    scheduler->Block(this);
     while ((nextThread = scheduler->FindNextToRun()) == NULL) {
         interrupt->Idle();  // No one to run, wait for an interrupt.
     }
 
+    // If the thread itself was woken up while the CPU idled, it never left
+    // it.
+    if (nextThread != this) {
+        voluntarySwitches++;
+        stats->numVoluntarySwitches++;
+    }
     scheduler->Run(nextThread);  // Returns when we have been signalled.
 }
 
+/// Unlike yielding until enough time has passed, this lets the CPU idle,
+/// or other threads run, meanwhile.  See `AlarmClock`.
+void
+Thread::SleepFor(unsigned ticks)
+{
+    ASSERT(this == currentThread);
+
+    DEBUG('t', "Thread \"%s\" sleeping for %u ticks\n", getName(), ticks);
+
+    alarmClock->SleepFor(ticks);
+}
+
 /// ThreadFinish, InterruptEnable
 ///
 /// Dummy functions because C++ does not allow a pointer to a member
@@ -265,9 +363,16 @@ ThreadFinish()
     currentThread->Finish();
 }
 
+/// A new thread does not return from `SWITCH` into `Scheduler::Run`, so the
+/// thread that finished just before it starts is destroyed here instead;
+/// otherwise its stack would never go back to the pool.
 static void
 InterruptEnable()
 {
+    if (threadToBeDestroyed != NULL) {
+        delete threadToBeDestroyed;
+        threadToBeDestroyed = NULL;
+    }
     interrupt->Enable();
 }
 
@@ -284,11 +389,11 @@ InterruptEnable()
 void
 Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 {
-    stack = (HostMemoryAddress *) AllocBoundedArray(STACK_SIZE
-                                                    * sizeof *stack);
+    stack = (HostMemoryAddress *) stackPool->Allocate();
 
     // i386 & MIPS & SPARC stack works from high addresses to low addresses.
-    stackTop = stack + STACK_SIZE - 4;  // -4 to be on the safe side!
+    stackTop = stack + stackPool->GetStackSize() / sizeof *stack - 4;
+      // -4 to be on the safe side!
 
     // the 80386 passes the return address on the stack.  In order for
     // `SWITCH` to go to `ThreadRoot` when we switch to this thread, the
@@ -39,6 +39,7 @@
 #define NACHOS_THREADS_THREAD__HH
 
 
+#include "list.hh"
 #include "utility.hh"
 
 #ifdef USER_PROGRAM
@@ -49,7 +50,9 @@
 #define MAX_OPEN_FILES 100
 #endif
 
+class Lock;
 class Port;
+class RWLock;
 
 /// CPU register state to be saved on context switch.
 ///
@@ -57,13 +60,17 @@ class Port;
 /// registers.  We allocate room for the maximum of these two architectures.
 const unsigned MACHINE_STATE_SIZE = 17;
 
-/// Size of the thread's private execution stack.
+/// Size of the thread's private execution stack, unless another one is
+/// given with `-ss`.
 ///
 /// In words.
 ///
 /// WATCH OUT IF THIS IS NOT BIG ENOUGH!!!!!
 const unsigned STACK_SIZE = 4 * 1024;
 
+/// Reader-writer locks a thread can hold at the same time.
+const unsigned MAX_HELD_RWLOCKS = 8;
+
 
 /// Thread state.
 enum ThreadStatus {
@@ -123,6 +130,11 @@ public:
 
     int GetRealPriority();
 
+    /// Return the priority the thread was created with.
+    int GetBasePriority();
+
+    void SetRealPriority(int prior);
+
     void RestorePriority();
 
     void ModifyPriority(int prior);
@@ -130,6 +142,9 @@ public:
     /// Put the thread to sleep and relinquish the processor.
     void Sleep();
 
+    /// Put the thread to sleep for at least `ticks` ticks.
+    void SleepFor(unsigned ticks);
+
     /// The thread is done executing.
     void Finish();
 
@@ -139,9 +154,21 @@ public:
     /// Check if thread has overflowed its stack.
     void CheckOverflow();
 
-    void setStatus(ThreadStatus st)
+    /// Change the status, charging the time spent in the old one to the
+    /// scheduling statistics of the thread.
+    ///
+    /// * `dispatched` is false when a thread that yielded goes on running
+    ///   because nothing else was ready; it never waited on the ready list,
+    ///   so no ready-to-run latency is counted.
+    void setStatus(ThreadStatus st, bool dispatched = true);
+
+    /// Charge the time spent in the current status so far, so that the
+    /// scheduling statistics are up to date, without changing it.
+    void UpdateTicks();
+
+    ThreadStatus getStatus()
     {
-        status = st;
+        return status;
     }
 
     const char *getName()
@@ -154,6 +181,38 @@ public:
         printf("%s, ", name);
     }
 
+    /// Links for the ready list or the queue of a semaphore or lock, since a
+    /// thread is on at most one of them at a time.
+    ListLink<Thread> queueLink;
+
+    /// Kept by `Lock`, for priority inheritance: the locks this thread
+    /// holds, linked through `Lock::nextHeld`, and the one it is waiting
+    /// for, if any.
+    Lock *heldLocks;
+    Lock *waitingFor;
+
+    /// Kept by `RWLock`, likewise: the reader-writer locks this thread
+    /// holds, for reading or for writing.
+    RWLock  *heldRWLocks[MAX_HELD_RWLOCKS];
+    unsigned numHeldRWLocks;
+
+    /// Kept by `AlarmClock`: when a sleeping thread is to be woken up.
+    unsigned long long wakeTime;
+
+    /// Scheduling statistics: ticks spent running, on the ready list and
+    /// blocked, kept by `setStatus`, and context switches away from the
+    /// thread, kept by `Yield` and `Sleep` (see `Statistics`).
+    unsigned long long runTicks;
+    unsigned long long readyTicks;
+    unsigned long long blockedTicks;
+    unsigned voluntarySwitches;
+    unsigned involuntarySwitches;
+
+    /// Kept by `Scheduler` for the multilevel feedback queue: ticks run in
+    /// the current quantum, and the last priority boost the thread got.
+    unsigned long long quantumTicks;
+    unsigned boostEpoch;
+
 private:
     // Some of the private data for this class is listed above.
 
@@ -163,8 +222,9 @@ private:
     /// stack.)
     HostMemoryAddress *stack;
 
-    /// Ready, running or blocked.
+    /// Ready, running or blocked, and since when.
     ThreadStatus status;
+    unsigned long long statusSince;
 
     const char *name;
 
@@ -178,6 +238,7 @@ private:
     /// The priority that the process has in the scheduler
     int priority;
     int realPriority;
+    int basePriority;
 
 #ifdef USER_PROGRAM
     /// User-level CPU register state.
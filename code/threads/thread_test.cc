@@ -12,10 +12,49 @@
 
 #define NUM_THREADS 5
 
+#include "thread_test.hh"
 #include "system.hh"
 #include "synch.hh"
 #include <unistd.h>
- 
+
+
+BenchClock::BenchClock()
+{
+    Restart();
+}
+
+void
+BenchClock::Restart()
+{
+    gettimeofday(&start, NULL);
+    startTicks = stats->totalTicks;
+}
+
+double
+BenchClock::Seconds() const
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec - start.tv_sec + (now.tv_usec - start.tv_usec) / 1e6;
+}
+
+void
+BenchClock::Report(const char *what, unsigned count, const char *things) const
+{
+    double seconds = Seconds();
+    printf("%s: %u %s in %.3f s, %.0f per second, %.1f ns and %.1f ticks "
+           "each\n", what, count, things, seconds, count / seconds,
+           seconds * 1e9 / count,
+           (double) (stats->totalTicks - startTicks) / count);
+}
+
+void
+Say(const char *what)
+{
+    printf("[tick %5llu] %-6s (priority %d) %s\n", stats->totalTicks,
+           currentThread->getName(), currentThread->GetPriority(), what);
+}
+
 #ifdef DEADLOCK_TEST
 Semaphore *blisto = new Semaphore("blisto", 0);
 Semaphore *blisto2 = new Semaphore("blisto2", 0);
@@ -127,6 +166,58 @@ ThreadTest()
 {
     DEBUG('t', "Entering SimpleTest");
 
+#ifdef INTERRUPT_BENCH
+    InterruptBench();
+#endif
+
+#ifdef SWITCH_BENCH
+    SwitchBench();
+#endif
+
+#ifdef INHERITANCE_TEST
+    InheritanceTest();
+#endif
+
+#ifdef MLFQ_TEST
+    MlfqTest();
+#endif
+
+#ifdef RWLOCK_TEST
+    RWLockTest();
+#endif
+
+#ifdef FORK_BENCH
+    ForkBench();
+#endif
+
+#ifdef PREEMPT_TEST
+    PreemptTest();
+#endif
+
+#ifdef LOCK_BENCH
+    LockBench();
+#endif
+
+#ifdef CONDITION_TEST
+    ConditionTest();
+#endif
+
+#ifdef CHANNEL_BENCH
+    ChannelBench();
+#endif
+
+#ifdef ALARM_TEST
+    AlarmTest();
+#endif
+
+#ifdef WORK_QUEUE_BENCH
+    WorkQueueBench();
+#endif
+
+#ifdef SLAB_BENCH
+    SlabBench();
+#endif
+
 #ifdef COND_TEST
     Thread *firstThread, *secondThread, *thirdThread;
 
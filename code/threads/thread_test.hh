@@ -0,0 +1,58 @@
+/// Tests and benchmarks of the threads assignment.
+///
+/// Each of them lives in a file of its own, named after the definition
+/// that selects it in the `Makefile` (for example, `LOCK_BENCH` in
+/// `lock_bench.cc`), and `ThreadTest` runs the ones selected.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_THREADTEST__HH
+#define NACHOS_THREADS_THREADTEST__HH
+
+
+#include <sys/time.h>
+
+
+/// Measures host and simulated time, from construction or the last
+/// `Restart`, for the benchmarks.
+class BenchClock {
+public:
+
+    BenchClock();
+
+    void Restart();
+
+    /// Host time elapsed, in seconds.
+    double Seconds() const;
+
+    /// Print how long `count` `things` took, per second and each, in host
+    /// time and in ticks, as `what: count things in ...`.
+    void Report(const char *what, unsigned count, const char *things) const;
+
+private:
+
+    struct timeval     start;
+    unsigned long long startTicks;
+};
+
+/// Print `what` the current thread does, with the time and its priority.
+void Say(const char *what);
+
+void AlarmTest();
+void ChannelBench();
+void ConditionTest();
+void ForkBench();
+void InheritanceTest();
+void InterruptBench();
+void LockBench();
+void MlfqTest();
+void PreemptTest();
+void RWLockTest();
+void SlabBench();
+void SwitchBench();
+void WorkQueueBench();
+
+
+#endif
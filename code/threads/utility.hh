@@ -8,6 +8,10 @@
 /// * `+` -- turn on all debug messages.
 /// * `t` -- thread system.
 /// * `s` -- semaphores, locks, and conditions.
+/// * `k` -- contention on semaphores, locks, and conditions, reported at
+///   shutdown (see `synch_profile.hh`).
+/// * `h` -- use of the slab allocators, reported at shutdown (see
+///   `slab.hh`).
 /// * `i` -- interrupt emulation.
 /// * `m` -- machine emulation (requires *USER_PROGRAM*).
 /// * `d` -- disk emulation (requires *FILESYS*).
@@ -0,0 +1,126 @@
+/// Routines to run kernel jobs on a pool of worker threads.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "work_queue.hh"
+#include "system.hh"
+
+
+WorkQueue::WorkQueue(const char *debugName, unsigned count, int priority)
+{
+    ASSERT(count > 0);
+    name       = debugName;
+    numPending = 0;
+    numRunning = 0;
+    stopping   = false;
+    lock       = new Lock(debugName);
+    jobReady   = new Condition(debugName, lock);
+    idle       = new Condition(debugName, lock);
+
+    numWorkers = count;
+    workers    = new Thread *[count];
+    for (unsigned i = 0; i < count; i++) {
+        workers[i] = new Thread(debugName, true, priority);
+        workers[i]->Fork(Work, this);
+    }
+}
+
+/// The workers finish the jobs waiting before they stop.
+WorkQueue::~WorkQueue()
+{
+    lock->Acquire();
+    stopping = true;
+    jobReady->Broadcast();
+    lock->Release();
+    for (unsigned i = 0; i < numWorkers; i++)
+        workers[i]->Join();
+
+    Job *job;
+    while ((job = freeJobs.Remove()) != NULL)
+        delete job;
+    delete [] workers;
+    delete idle;
+    delete jobReady;
+    delete lock;
+}
+
+void
+WorkQueue::Submit(VoidFunctionPtr func, void *arg, int priority)
+{
+    ASSERT(priority >= 0 && priority < NUMBER_OF_PRIORITIES);
+    lock->Acquire();
+    ASSERT(!stopping);
+
+    Job *job = freeJobs.Remove();
+    if (job == NULL)
+        job = new Job;
+    job->func = func;
+    job->arg  = arg;
+    pending[priority].Append(job);
+    numPending++;
+
+    jobReady->Signal();
+    lock->Release();
+}
+
+/// A job must not call this, since it would wait for itself.
+void
+WorkQueue::Drain()
+{
+    lock->Acquire();
+    while (numPending > 0 || numRunning > 0)
+        idle->Wait();
+    lock->Release();
+}
+
+/// Jobs are shared out among the workers, so that a batch does not keep
+/// jobs waiting behind a job that blocks while other workers could run
+/// them.  Called with the lock held.
+unsigned
+WorkQueue::Take(Job **batch)
+{
+    unsigned max = divRoundUp(numPending, numWorkers), count = 0;
+
+    if (max > WORK_BATCH)
+        max = WORK_BATCH;
+    for (int i = NUMBER_OF_PRIORITIES - 1; i >= 0 && count < max; i--)
+        while (count < max && !pending[i].IsEmpty())
+            batch[count++] = pending[i].Remove();
+    numPending -= count;
+    return count;
+}
+
+/// Run batches of jobs, with the lock released, until the queue is empty
+/// and stopping.
+void
+WorkQueue::Work(void *queue_)
+{
+    WorkQueue *queue = (WorkQueue *) queue_;
+    Job       *batch[WORK_BATCH];
+
+    queue->lock->Acquire();
+    for (;;) {
+        while (queue->numPending == 0 && !queue->stopping)
+            queue->jobReady->Wait();
+        if (queue->numPending == 0)
+            break;
+
+        unsigned count = queue->Take(batch);
+        queue->numRunning += count;
+        queue->lock->Release();
+
+        for (unsigned i = 0; i < count; i++)
+            batch[i]->func(batch[i]->arg);
+
+        queue->lock->Acquire();
+        for (unsigned i = 0; i < count; i++)
+            queue->freeJobs.Append(batch[i]);
+        queue->numRunning -= count;
+        if (queue->numPending == 0 && queue->numRunning == 0)
+            queue->idle->Broadcast();
+    }
+    queue->lock->Release();
+}
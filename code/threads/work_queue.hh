@@ -0,0 +1,91 @@
+/// Data structures for running kernel jobs on a pool of worker threads.
+///
+/// Forking a thread for every small job in the background costs a thread,
+/// a stack and a context switch or two each time.  A work queue instead has
+/// a fixed set of worker threads that take jobs -- a function and its
+/// argument -- off a queue and run them one after the other.  Jobs of higher
+/// priority are taken first, and a worker takes several jobs at once when
+/// there are, so that small jobs do not each pay for taking the lock.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_WORKQUEUE__HH
+#define NACHOS_THREADS_WORKQUEUE__HH
+
+
+#include "list.hh"
+#include "scheduler.hh"
+#include "synch.hh"
+
+
+/// Most jobs a worker takes off the queue at once.
+const unsigned WORK_BATCH = 8;
+
+/// The following class defines a work queue and its worker threads.
+class WorkQueue {
+public:
+
+    /// Initialize an empty queue, and fork `numWorkers` threads of
+    /// `priority` to run its jobs.
+    WorkQueue(const char *debugName, unsigned numWorkers, int priority);
+
+    /// Run the jobs left, stop the workers and de-allocate the queue.
+    ~WorkQueue();
+
+    const char *GetName()
+    {
+        return name;
+    }
+
+    /// Have a worker call `func(arg)`.  Jobs with a higher `priority` are
+    /// run first, and jobs of the same priority in the order they were
+    /// submitted; the workers themselves keep their own priority.
+    void Submit(VoidFunctionPtr func, void *arg, int priority = 0);
+
+    /// Wait until every job submitted so far, and every job those submit,
+    /// has run.
+    void Drain();
+
+private:
+
+    struct Job {
+        VoidFunctionPtr func;
+        void *arg;
+        ListLink<Job> link;
+    };
+
+    typedef IntrusiveList<Job, &Job::link> JobList;
+
+    /// Body of the worker threads.
+    static void Work(void *queue);
+
+    /// Take up to `WORK_BATCH` jobs of the highest priority waiting off the
+    /// queue, into `batch`.  Returns how many were taken.
+    unsigned Take(Job **batch);
+
+    const char *name;
+
+    /// Jobs waiting, one list for every priority, and records of jobs that
+    /// have run, to be used again, so that submitting does not allocate.
+    JobList  pending[NUMBER_OF_PRIORITIES];
+    JobList  freeJobs;
+    unsigned numPending;
+
+    /// Jobs taken by workers but not finished yet.
+    unsigned numRunning;
+
+    bool stopping;
+
+    Lock      *lock;
+    Condition *jobReady;  ///< Signaled when a job is submitted.
+    Condition *idle;      ///< Broadcast when no job is left at all.
+
+    Thread  **workers;
+    unsigned numWorkers;
+
+};
+
+
+#endif
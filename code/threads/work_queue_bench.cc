@@ -0,0 +1,98 @@
+/// Benchmark of running jobs on a work queue rather than a thread each.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef WORK_QUEUE_BENCH
+
+#include "thread_test.hh"
+#include "work_queue.hh"
+#include "synch.hh"
+#include "system.hh"
+
+
+/// Number of jobs run, how many are submitted at a time, and number of
+/// workers of the queue.
+static const unsigned WORK_JOBS    = 200000;
+static const unsigned WORK_AT_ONCE = 16;
+static const unsigned WORK_THREADS = 4;
+
+static Semaphore *jobDone, *firstJobGo;
+static unsigned   jobsRun, jobOrder[4], numOrdered;
+
+static void
+CountJob(void *arg)
+{
+    jobsRun++;
+}
+
+static void
+SignalJob(void *arg)
+{
+    jobsRun++;
+    jobDone->V();
+}
+
+static void
+BlockingJob(void *arg)
+{
+    firstJobGo->P();
+}
+
+static void
+OrderedJob(void *which)
+{
+    jobOrder[numOrdered++] = (unsigned) (long) which;
+}
+
+/// Run small jobs in a thread each, and on a work queue; then check that
+/// jobs of higher priority are run first.
+void
+WorkQueueBench()
+{
+    jobDone = new Semaphore("jobDone", 0);
+    jobsRun = 0;
+    BenchClock clock;
+    for (unsigned i = 0; i < WORK_JOBS; i += WORK_AT_ONCE) {
+        for (unsigned j = 0; j < WORK_AT_ONCE; j++)
+            (new Thread("job", false, 9))->Fork(SignalJob, NULL);
+        for (unsigned j = 0; j < WORK_AT_ONCE; j++)
+            jobDone->P();
+    }
+    clock.Report("Thread per job", WORK_JOBS, "jobs");
+    ASSERT(jobsRun == WORK_JOBS);
+
+    WorkQueue *queue = new WorkQueue("work", WORK_THREADS, 9);
+    jobsRun = 0;
+    clock.Restart();
+    for (unsigned i = 0; i < WORK_JOBS; i += WORK_AT_ONCE) {
+        for (unsigned j = 0; j < WORK_AT_ONCE; j++)
+            queue->Submit(CountJob, NULL);
+        queue->Drain();
+    }
+    clock.Report("Work queue", WORK_JOBS, "jobs");
+    ASSERT(jobsRun == WORK_JOBS);
+    delete queue;
+
+    // The only worker is kept busy while jobs are submitted.
+    firstJobGo = new Semaphore("firstJobGo", 0);
+    queue = new WorkQueue("ordered", 1, 9);
+    queue->Submit(BlockingJob, NULL);
+    currentThread->Yield();
+    queue->Submit(OrderedJob, (void *) 3, 1);
+    queue->Submit(OrderedJob, (void *) 1, 5);
+    queue->Submit(OrderedJob, (void *) 4, 1);
+    queue->Submit(OrderedJob, (void *) 2, 5);
+    firstJobGo->V();
+    queue->Drain();
+    for (unsigned i = 0; i < 4; i++)
+        ASSERT(jobOrder[i] == i + 1);
+    printf("Jobs ran by priority\n");
+    delete queue;
+    delete firstJobGo;
+    delete jobDone;
+}
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "address_space.hh"
 #include "bin/noff.h"
+#include "machine/profile.hh"
 #include "threads/system.hh"
 
 
@@ -48,8 +49,8 @@ SwapHeader(NoffHeader *noffH)
 /// Assumes that the object code file is in NOFF format.
 ///
 /// First, set up the translation from program memory to physical memory.
-/// For now, this is really simple (1:1), since we are only uniprogramming,
-/// and we have a single unsegmented page table.
+/// Every virtual page gets a free physical page from `frameMap`, and we have
+/// a single unsegmented page table.
 ///
 /// * `executable` is the file containing the object code to load into
 ///   memory.
@@ -72,7 +73,7 @@ AddressSpace::AddressSpace(OpenFile *executable)
     numPages = divRoundUp(size, PAGE_SIZE);
     size = numPages * PAGE_SIZE;
 
-    ASSERT(numPages <= NUM_PHYS_PAGES);
+    ASSERT(numPages <= frameMap->NumClear());
       // Check we are not trying to run anything too big -- at least until we
       // have virtual memory.
 
@@ -84,45 +85,130 @@ AddressSpace::AddressSpace(OpenFile *executable)
     pageTable = new TranslationEntry[numPages];
     for (unsigned i = 0; i < numPages; i++) {
         pageTable[i].virtualPage  = i;
-          // For now, virtual page number = physical page number.
-        pageTable[i].physicalPage = i;
+        pageTable[i].physicalPage = frameMap->Find();
         pageTable[i].valid        = true;
         pageTable[i].use          = false;
         pageTable[i].dirty        = false;
         pageTable[i].readOnly     = false;
           // If the code segment was entirely on a separate page, we could
           // set its pages to be read-only.
-    }
+        machine->InvalidateFrame(pageTable[i].physicalPage);
+          // The frame is about to be loaded with new contents.
 
-    // Zero out the entire address space, to zero the unitialized data
-    // segment and the stack segment.
-    memset(machine->mainMemory, 0, size);
+        // Zero out the page, to zero the unitialized data segment and the
+        // stack segment.
+        memset(&machine->mainMemory[pageTable[i].physicalPage * PAGE_SIZE],
+               0, PAGE_SIZE);
+    }
 
     // Then, copy in the code and data segments into memory.
     if (noffH.code.size > 0) {
         DEBUG('a', "Initializing code segment, at 0x%X, size %u\n",
               noffH.code.virtualAddr, noffH.code.size);
-        executable->ReadAt(&(machine->mainMemory[noffH.code.virtualAddr]),
-                           noffH.code.size, noffH.code.inFileAddr);
+        LoadSegment(executable, noffH.code.virtualAddr, noffH.code.size,
+                    noffH.code.inFileAddr);
     }
     if (noffH.initData.size > 0) {
         DEBUG('a', "Initializing data segment, at 0x%X, size %u\n",
               noffH.initData.virtualAddr, noffH.initData.size);
-        executable->ReadAt(
-          &(machine->mainMemory[noffH.initData.virtualAddr]),
-          noffH.initData.size, noffH.initData.inFileAddr);
+        LoadSegment(executable, noffH.initData.virtualAddr,
+                    noffH.initData.size, noffH.initData.inFileAddr);
     }
 
+    if (machine->profile != NULL) {
+        machine->profile->AddText(noffH.code.virtualAddr, noffH.code.size);
+        unsigned codeEnd = noffH.code.inFileAddr + noffH.code.size;
+        unsigned dataEnd = noffH.initData.inFileAddr + noffH.initData.size;
+        LoadSymbols(executable, codeEnd > dataEnd ? codeEnd : dataEnd);
+    }
 }
 
-/// Deallocate an address space.
-///
-/// Nothing for now!
+/// Deallocate an address space, giving its physical pages back.
 AddressSpace::~AddressSpace()
 {
+    for (unsigned i = 0; i < numPages; i++)
+        frameMap->Clear(pageTable[i].physicalPage);
     delete [] pageTable;
 }
 
+/// Copy a segment of the executable into the address space, a page at a
+/// time, since consecutive virtual pages need not be in consecutive
+/// physical pages.
+///
+/// * `executable` is the file containing the object code.
+/// * `virtualAddr` is where the segment starts in the address space.
+/// * `size` is the size of the segment, in bytes.
+/// * `inFileAddr` is where the segment starts in the file.
+void
+AddressSpace::LoadSegment(OpenFile *executable, unsigned virtualAddr,
+                          unsigned size, unsigned inFileAddr)
+{
+    while (size > 0) {
+        unsigned page   = virtualAddr / PAGE_SIZE;
+        unsigned offset = virtualAddr % PAGE_SIZE;
+        unsigned span   = PAGE_SIZE - offset;
+        if (span > size)
+            span = size;
+
+        ASSERT(page < numPages);
+        executable->ReadAt(&machine->mainMemory[
+                             pageTable[page].physicalPage * PAGE_SIZE + offset],
+                           span, inFileAddr);
+        virtualAddr += span;
+        inFileAddr  += span;
+        size        -= span;
+    }
+}
+
+/// Read the symbol section written by `coff2noff` (see `bin/noff.h`).
+///
+/// * `executable` is the file containing the object code.
+/// * `inFileAddr` is where the last segment stored in the file ends.
+void
+AddressSpace::LoadSymbols(OpenFile *executable, unsigned inFileAddr)
+{
+    NoffSymbolHeader symH;
+    bool             swap = false;
+
+    if (executable->ReadAt((char *) &symH, sizeof symH, inFileAddr)
+          != (int) sizeof symH)
+        return;
+    if (symH.noffSymMagic != NOFFSYMMAGIC
+          && (int) WordToHost(symH.noffSymMagic) == NOFFSYMMAGIC) {
+        symH.numSymbols = WordToHost(symH.numSymbols);
+        symH.namesSize  = WordToHost(symH.namesSize);
+        swap = true;
+    } else if (symH.noffSymMagic != NOFFSYMMAGIC)
+        return;
+    if (symH.numSymbols <= 0 || symH.namesSize <= 0)
+        return;
+
+    DEBUG('a', "Loading %d symbols for profiling\n", symH.numSymbols);
+
+    NoffSymbol *symbols = new NoffSymbol[symH.numSymbols];
+    char       *names   = new char[symH.namesSize + 1];
+    unsigned    symbolsSize = symH.numSymbols * sizeof *symbols;
+    inFileAddr += sizeof symH;
+    if (executable->ReadAt((char *) symbols, symbolsSize, inFileAddr)
+            == (int) symbolsSize
+          && executable->ReadAt(names, symH.namesSize,
+                                inFileAddr + symbolsSize)
+            == symH.namesSize) {
+        names[symH.namesSize] = '\0';  // In case the last one is cut.
+        for (int i = 0; i < symH.numSymbols; i++) {
+            unsigned value = symbols[i].value, name = symbols[i].name;
+            if (swap) {
+                value = WordToHost(value);
+                name  = WordToHost(name);
+            }
+            if (name < (unsigned) symH.namesSize)
+                machine->profile->AddSymbol(value, &names[name]);
+        }
+    }
+    delete [] symbols;
+    delete [] names;
+}
+
 /// Set the initial values for the user-level register set.
 ///
 /// We write these directly into the “machine” registers, so that we can
@@ -165,4 +251,5 @@ void AddressSpace::RestoreState()
 {
     machine->pageTable     = pageTable;
     machine->pageTableSize = numPages;
+    machine->FlushTranslationCache();
 }
@@ -43,6 +43,15 @@ public:
 
 private:
 
+    /// Copy `size` bytes at `inFileAddr` in `executable` to `virtualAddr`.
+    void LoadSegment(OpenFile *executable, unsigned virtualAddr,
+                     unsigned size, unsigned inFileAddr);
+
+    /// Hand the routine names in the symbol section of `executable`, which
+    /// starts at `inFileAddr`, to the profiler.  Do nothing if there is no
+    /// symbol section.
+    void LoadSymbols(OpenFile *executable, unsigned inFileAddr);
+
     /// Assume linear page table translation for now!
     TranslationEntry *pageTable;
 
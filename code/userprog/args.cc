@@ -1,12 +1,18 @@
-#include "machine/machine.h"
+#include "args.hh"
+#include "threads/system.hh"
 
 
 const unsigned MAX_ARG_COUNT  = 32;
 const unsigned MAX_ARG_LENGTH = 128;
 
+// Defined in `exception.cc`; they fail if the user address is bad.
 void ReadStringFromUser(int userAddress, char *outString,
                         unsigned maxByteCount);
+void ReadBufferFromUser(int userAddress, char *outBuffer,
+                        unsigned byteCount);
 void WriteStringToUser(const char *string, int userAddress);
+void WriteBufferToUser(const char *buffer, int userAddress,
+                       unsigned byteCount);
 
 void
 WriteArgs(char **args)
@@ -16,16 +22,16 @@ WriteArgs(char **args)
     DEBUG('e', "Writing command line arguments into child process.\n");
 
     // Start writing the arguments where the current SP points.
-    int args_address[MAX_ARG_COUNT];
+    int args_address[MAX_ARG_COUNT + 1];
     unsigned i;
-    int sp = machine->ReadRegister(StackReg);
+    int sp = machine->ReadRegister(STACK_REG);
     for (i = 0; i < MAX_ARG_COUNT; i++) {
         if (args[i] == NULL)        // If the last was reached, terminate.
             break;
         sp -= strlen(args[i]) + 1;  // Decrease SP (leave one byte for \0).
         WriteStringToUser(args[i], sp);  // Write the string there.
         args_address[i] = sp;       // Save the argument's address.
-        delete args[i];             // Free the memory.
+        delete [] args[i];          // Free the memory.
     }
     ASSERT(i < MAX_ARG_COUNT);
 
@@ -34,12 +40,13 @@ WriteArgs(char **args)
     for (unsigned j = 0; j < i; j++)
         // Save the address of the j-th argument counting from the end down
         // to the beginning.
-        machine->WriteMem(sp + 4 * j, 4, args_address[j]);
-    machine->WriteMem(sp + 4 * i, 4, 0);  // The last is NULL.
+        args_address[j] = WordToMachine(args_address[j]);
+    args_address[i] = 0;  // The last is NULL.
+    WriteBufferToUser((const char *) args_address, sp, i * 4 + 4);
     sp -= 16;  // Make room for the “register saves”.
 
-    machine->WriteRegister(StackReg, sp);
-    delete args;  // Free the array.
+    machine->WriteRegister(STACK_REG, sp);
+    delete [] args;  // Free the array.
 }
 
 char **
@@ -51,7 +58,8 @@ SaveArgs(int address)
     int val;
     unsigned i = 0;
     do {
-        machine->ReadMem(address + i * 4, 4, &val);
+        ReadBufferFromUser(address + i * 4, (char *) &val, 4);
+        val = WordToHost(val);
         i++;
     } while (i < MAX_ARG_COUNT && val != 0);
     if (i == MAX_ARG_COUNT && val != 0)
@@ -66,7 +74,8 @@ SaveArgs(int address)
     for (unsigned j = 0; j < i - 1; j++) {
         // For each pointer, read the corresponding string.
         ret[j] = new char [MAX_ARG_LENGTH];
-        machine->ReadMem(address + j * 4, 4, &val);
+        ReadBufferFromUser(address + j * 4, (char *) &val, 4);
+        val = WordToHost(val);
         ReadStringFromUser(val, ret[j], MAX_ARG_LENGTH);
     }
     ret[i - 1] = NULL;  // Write the trailing NULL.
@@ -0,0 +1,24 @@
+/// Routines to pass command line arguments to a new user program.
+///
+/// Copyright (c) 2016-2017 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_ARGS__HH
+#define NACHOS_USERPROG_ARGS__HH
+
+
+/// Copy the `NULL`-terminated array of strings at `address`, in the memory
+/// of the current user program, into the kernel.
+///
+/// Returns `NULL` if there are too many arguments.  The result is to be
+/// passed to `WriteArgs`, which de-allocates it.
+char **SaveArgs(int address);
+
+/// Write `args`, as returned by `SaveArgs`, on the stack of the current
+/// user program, followed by the array of pointers to them, and leave the
+/// stack pointer below.  `args` is de-allocated.
+void WriteArgs(char **args);
+
+
+#endif
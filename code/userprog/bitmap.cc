@@ -10,6 +10,9 @@
 #include "bitmap.hh"
 
 
+SlabAllocator BitMap::slab;
+
+
 /// Initialize a bitmap with `nitems` bits, so that every bit is clear.  It
 /// can be added somewhere on a list.
 ///
@@ -19,8 +22,10 @@ BitMap::BitMap(unsigned nitems)
     numBits  = nitems;
     numWords = divRoundUp(numBits, BitsInWord);
     map      = new unsigned [numWords];
-    for (unsigned i = 0; i < numBits; i++)
-        Clear(i);
+    for (unsigned i = 0; i < numWords; i++)
+        map[i] = 0;
+    numClear  = numBits;
+    firstFree = 0;
 }
 
 /// De-allocate a bitmap.
@@ -36,7 +41,10 @@ void
 BitMap::Mark(unsigned which)
 {
     ASSERT(which < numBits);
-    map[which / BitsInWord] |= 1 << which % BitsInWord;
+    if (!Test(which)) {
+        map[which / BitsInWord] |= 1 << which % BitsInWord;
+        numClear--;
+    }
 }
 
 /// Clear the “nth” bit in a bitmap.
@@ -46,7 +54,12 @@ void
 BitMap::Clear(unsigned which)
 {
     ASSERT(which < numBits);
-    map[which / BitsInWord] &= ~(1 << which % BitsInWord);
+    if (Test(which)) {
+        map[which / BitsInWord] &= ~(1 << which % BitsInWord);
+        numClear++;
+        if (which / BitsInWord < firstFree)
+            firstFree = which / BitsInWord;
+    }
 }
 
 /// Return true if the “nth” bit is set.
@@ -64,28 +77,30 @@ BitMap::Test(unsigned which)
 /// the bit (mark it as in use).  (In other words, find and allocate a bit.)
 ///
 /// If no bits are clear, return -1.
+///
+/// Whole words are skipped while they are full, starting from the first one
+/// that may have a clear bit, so that allocating from a large bitmap does
+/// not go through the bits one by one.
 int
 BitMap::Find()
 {
-    for (unsigned i = 0; i < numBits; i++)
-        if (!Test(i)) {
-            Mark(i);
-            return i;
-        }
-    return -1;
+    if (numClear == 0)
+        return -1;
+    while (map[firstFree] == ~0U)
+        firstFree++;
+
+    unsigned which = firstFree * BitsInWord + __builtin_ctz(~map[firstFree]);
+    ASSERT(which < numBits);
+    Mark(which);
+    return which;
 }
 
 /// Return the number of clear bits in the bitmap.  (In other words, how many
 /// bits are unallocated?)
 unsigned
-BitMap::NumClear()
+BitMap::NumClear() const
 {
-    unsigned count = 0;
-
-    for (unsigned i = 0; i < numBits; i++)
-        if (!Test(i))
-            count++;
-    return count;
+    return numClear;
 }
 
 /// Print the contents of the bitmap, for debugging.
@@ -111,6 +126,7 @@ void
 BitMap::FetchFrom(OpenFile *file)
 {
     file->ReadAt((char *) map, numWords * sizeof (unsigned), 0);
+    Recount();
 }
 
 /// Store the contents of a bitmap to a Nachos file.
@@ -123,3 +139,15 @@ BitMap::WriteBack(OpenFile *file)
 {
    file->WriteAt((char *) map, numWords * sizeof (unsigned), 0);
 }
+
+void
+BitMap::Recount()
+{
+    numClear  = 0;
+    firstFree = numWords;
+    for (unsigned i = numBits; i > 0; i--)
+        if (!Test(i - 1)) {
+            numClear++;
+            firstFree = (i - 1) / BitsInWord;
+        }
+}
@@ -18,6 +18,7 @@
 
 
 #include "filesys/open_file.hh"
+#include "threads/slab.hh"
 #include "threads/utility.hh"
 
 
@@ -62,7 +63,7 @@ public:
     int Find();
 
     /// Return the number of clear bits.
-    unsigned NumClear();
+    unsigned NumClear() const;
 
     /// Print contents of bitmap.
     void Print();
@@ -79,8 +80,17 @@ public:
     /// need to read and write the bitmap to a file.
     void WriteBack(OpenFile *file);
 
+    /// Bitmaps are taken from a slab, since the free map is read for every
+    /// file created or removed.
+    void *operator new(size_t size)
+    { return slab.Allocate("bitmap", size); }
+    void operator delete(void *bitmap)
+    { slab.Free(bitmap); }
+
 private:
 
+    static SlabAllocator slab;
+
     /// Number of bits in the bitmap.
     unsigned numBits;
 
@@ -91,6 +101,15 @@ private:
     /// Bit storage.
     unsigned *map;
 
+    /// Number of bits that are clear.
+    unsigned numClear;
+
+    /// No word before this one has a clear bit, so `Find` starts here.
+    unsigned firstFree;
+
+    /// Recompute `numClear` and `firstFree` from `map`.
+    void Recount();
+
 };
 
 
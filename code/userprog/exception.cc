@@ -27,6 +27,10 @@
 #include "machine/console.hh"
 #include "filesys/file_system.hh"
 
+
+static_assert(STATS_LATENCY_BUCKETS == LATENCY_BUCKETS,
+              "the Stats system call copies the whole latency histogram");
+
 /// Entry point into the Nachos kernel.  Called when a user program is
 /// executing, and either does a syscall, or generates an addressing or
 /// arithmetic exception.
@@ -51,41 +55,37 @@
 void
 ReadStringFromUser (int userAddress, char *outString, unsigned maxByteCount)
 {
-    int buffer;
-    for (unsigned i = 0; i<maxByteCount; i++) {
-        ASSERT(machine->ReadMem(userAddress+i, 1, &buffer)); 
-        outString[i] = buffer;
-        if (outString[i] == '\0')
-            break;
-    }
+    ASSERT(machine->CopyStringFromUser(userAddress, outString, maxByteCount));
 }
 
 void
 ReadBufferFromUser (int userAddress, char *outBuffer, unsigned byteCount)
 {
-    int buffer;
-    for (unsigned i = 0; i<byteCount; i++) {
-        ASSERT(machine->ReadMem(userAddress+i, 1, &buffer)); 
-        outBuffer[i] = buffer;
-    }
+    ASSERT(machine->CopyFromUser(userAddress, outBuffer, byteCount));
 }
 
 void
 WriteStringToUser (const char *buffer, int userAddress)
 {
-    int i=0;
-    do {
-        ASSERT(machine->WriteMem(userAddress+i, 1, buffer[i]));
-    } while (buffer[i++] != '\0');
+    ASSERT(machine->CopyToUser(userAddress, buffer, strlen(buffer) + 1));
 }
 
 void
 WriteBufferToUser (const char *buffer, int userAddress, unsigned byteCount)
 {
-    unsigned i=0;
-    do {
-        ASSERT(machine->WriteMem(userAddress+i, 1, buffer[i]));
-    } while (i++ < byteCount);
+    ASSERT(machine->CopyToUser(userAddress, buffer, byteCount));
+}
+
+/// Move the program counter past the `syscall` instruction, so that the
+/// user program goes on with the next one when the system call returns.
+static void
+IncrementPC()
+{
+    int pc = machine->ReadRegister(NEXT_PC_REG);
+
+    machine->WriteRegister(PREV_PC_REG, machine->ReadRegister(PC_REG));
+    machine->WriteRegister(PC_REG, pc);
+    machine->WriteRegister(NEXT_PC_REG, pc + 4);
 }
 
 void
@@ -172,7 +172,6 @@ ExceptionHandler(ExceptionType which)
                 else
                     DEBUG('a', "Error while opening file: %s", name);
                 machine->WriteRegister(2, fid);
-                // incrementar pc 
                 break;
             }
             case SC_Close: {
@@ -185,10 +184,37 @@ ExceptionHandler(ExceptionType which)
                 
                 break; 
             }
+            case SC_Sleep: {
+                int ticks = machine->ReadRegister(4);
+                DEBUG('a', "Sleeping for %d ticks\n", ticks);
+                if (ticks > 0)
+                    currentThread->SleepFor(ticks);
+                break;
+            }
+            case SC_Stats: {
+                SchedulingStats s;
+                currentThread->UpdateTicks();
+                s.runTicks            = currentThread->runTicks;
+                s.readyTicks          = currentThread->readyTicks;
+                s.blockedTicks        = currentThread->blockedTicks;
+                s.voluntarySwitches   = currentThread->voluntarySwitches;
+                s.involuntarySwitches = currentThread->involuntarySwitches;
+                for (unsigned i = 0; i < LATENCY_BUCKETS; i++)
+                    s.readyLatency[i] = stats->readyLatency[i];
+
+                // Every field is a word, in the byte order of the machine.
+                int *words = (int *) &s;
+                for (unsigned i = 0; i < sizeof s / sizeof *words; i++)
+                    words[i] = WordToMachine(words[i]);
+                WriteBufferToUser((const char *) &s, machine->ReadRegister(4),
+                                  sizeof s);
+                break;
+            }
             default:
                 printf("Unexpected user mode exception %d %d\n", which, type);
                 ASSERT(false);
         }                
+        IncrementPC();
 
     } else {
         printf("Unexpected user mode exception %d %d\n", which, type);
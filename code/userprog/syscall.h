@@ -30,6 +30,8 @@
 #define SC_Close    8
 #define SC_Fork     9
 #define SC_Yield   10
+#define SC_Sleep   11
+#define SC_Stats   12
 
 
 #ifndef IN_ASM
@@ -118,6 +120,34 @@ void Fork(void (*func)());
 /// or not.
 void Yield();
 
+/// Give up the CPU for at least `ticks` ticks of simulated time.  Other
+/// threads run meanwhile, or the machine idles if there are none.
+void Sleep(int ticks);
+
+
+/// Scheduling statistics, to tune the time slice and priorities.
+
+/// Number of buckets of `readyLatency`.
+#define STATS_LATENCY_BUCKETS 16
+
+/// Ticks are truncated to 32 bits.
+typedef struct {
+    int runTicks;             ///< Time the thread ran.
+    int readyTicks;           ///< Time it waited on the ready list.
+    int blockedTicks;         ///< Time it was blocked.
+    int voluntarySwitches;    ///< Times it gave up the CPU to wait.
+    int involuntarySwitches;  ///< Times it was made to give it up.
+
+    /// For the whole machine: waits on the ready list of no time, in
+    /// bucket 0, and of `2^(i-1)` to `2^i - 1` ticks, in bucket `i`; the
+    /// last bucket counts longer waits too.
+    int readyLatency[STATS_LATENCY_BUCKETS];
+} SchedulingStats;
+
+/// Fill `stats` with the statistics of the calling thread, and the
+/// histogram of ready-to-run latencies.
+void Stats(SchedulingStats *stats);
+
 #endif
 
 